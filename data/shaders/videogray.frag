@@ -0,0 +1,43 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#version 450 core
+
+uniform sampler2D grayTexture;
+
+// Normalizes samples stored in a wider texture format, (2^16-1) / (2^bits-1)
+// Replicates the value to RGB when outputChannel is 0, otherwise writes it to R (1), G (2), B (3) or A (4) only
+uniform UBO
+{
+	float sampleScale;
+	int outputChannel;
+} ubo;
+
+in vec3 pass_Uvs;
+out vec4 out_Color;
+
+void main() 
+{
+	vec2 uvs = vec2(pass_Uvs.x, 1.0-pass_Uvs.y);
+	float value = clamp(texture(grayTexture, uvs).r * ubo.sampleScale, 0.0, 1.0);
+
+	switch (ubo.outputChannel)
+	{
+		case 1:
+			out_Color = vec4(value, 0.0, 0.0, 1.0);
+			break;
+		case 2:
+			out_Color = vec4(0.0, value, 0.0, 1.0);
+			break;
+		case 3:
+			out_Color = vec4(0.0, 0.0, value, 1.0);
+			break;
+		case 4:
+			out_Color = vec4(0.0, 0.0, 0.0, value);
+			break;
+		default:
+			out_Color = vec4(value, value, value, 1.0);
+			break;
+	}
+}
@@ -0,0 +1,46 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#version 450 core
+
+// Luma plane and interleaved chroma plane, the chroma texture is twice the chroma width
+uniform sampler2D yTexture;
+uniform sampler2D uvTexture;
+
+in vec3 pass_Uvs;
+out vec4 out_Color;
+
+// YUV to RGB conversion, same as the planar YUV shader
+const vec3 R_cf = vec3(1.164383,  0.000000,  1.596027);
+const vec3 G_cf = vec3(1.164383, -0.391762, -0.812968);
+const vec3 B_cf = vec3(1.164383,  2.017232,  0.000000);
+const vec3 offset = vec3(-0.0625, -0.5, -0.5);
+
+// Returns the chroma pair of a chroma sample, clamped to the edge
+vec2 fetchChroma(ivec2 coord, ivec2 size)
+{
+	coord = clamp(coord, ivec2(0), size - 1);
+	float u = texelFetch(uvTexture, ivec2(coord.x * 2, coord.y), 0).r;
+	float v = texelFetch(uvTexture, ivec2(coord.x * 2 + 1, coord.y), 0).r;
+	return vec2(u, v);
+}
+
+void main() 
+{
+	vec2 uvs = vec2(pass_Uvs.x, 1.0-pass_Uvs.y);
+	float y = texture(yTexture, uvs).r;
+
+	// Bilinear filter the interleaved chroma samples
+	ivec2 size = textureSize(uvTexture, 0);
+	size.x /= 2;
+	vec2 pos = uvs * vec2(size) - 0.5;
+	ivec2 base = ivec2(floor(pos));
+	vec2 weight = pos - vec2(base);
+	vec2 top = mix(fetchChroma(base, size), fetchChroma(base + ivec2(1, 0), size), weight.x);
+	vec2 bottom = mix(fetchChroma(base + ivec2(0, 1), size), fetchChroma(base + ivec2(1, 1), size), weight.x);
+	vec2 chroma = mix(top, bottom, weight.y);
+
+	vec3 yuv = vec3(y, chroma) + offset;
+	out_Color = vec4(dot(yuv, R_cf), dot(yuv, G_cf), dot(yuv, B_cf), 1.0);
+}
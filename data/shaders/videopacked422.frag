@@ -0,0 +1,73 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#version 450 core
+
+// Packed 4:2:2 frame, every RGBA texel holds two luma samples and the chroma pair they share
+uniform sampler2D packedTexture;
+
+// Byte order of the texels: UYVY (0), YUYV (1) or YVYU (2)
+uniform UBO
+{
+	int packedLayout;
+} ubo;
+
+in vec3 pass_Uvs;
+out vec4 out_Color;
+
+// YUV to RGB conversion, same as the planar YUV shader
+const vec3 R_cf = vec3(1.164383,  0.000000,  1.596027);
+const vec3 G_cf = vec3(1.164383, -0.391762, -0.812968);
+const vec3 B_cf = vec3(1.164383,  2.017232,  0.000000);
+const vec3 offset = vec3(-0.0625, -0.5, -0.5);
+
+// Returns the luma samples (xy) and the chroma pair (zw) of a texel
+vec4 unpack(vec4 texel)
+{
+	if (ubo.packedLayout == 1)
+		return texel.rbga;
+	if (ubo.packedLayout == 2)
+		return texel.rbag;
+	return texel.garb;
+}
+
+// Returns the unpacked texel at the given position, clamped to the edge
+vec4 fetchTexel(ivec2 coord, ivec2 size)
+{
+	coord = clamp(coord, ivec2(0), size - 1);
+	return unpack(texelFetch(packedTexture, coord, 0));
+}
+
+// Returns the luma sample of a pixel, clamped to the edge
+float fetchLuma(ivec2 coord, ivec2 size)
+{
+	coord = clamp(coord, ivec2(0), ivec2(size.x * 2, size.y) - 1);
+	vec4 texel = fetchTexel(ivec2(coord.x / 2, coord.y), size);
+	return (coord.x & 1) == 0 ? texel.x : texel.y;
+}
+
+void main() 
+{
+	vec2 uvs = vec2(pass_Uvs.x, 1.0-pass_Uvs.y);
+	ivec2 size = textureSize(packedTexture, 0);
+
+	// Bilinear filter the luma samples, two per texel
+	vec2 luma_pos = uvs * vec2(size.x * 2, size.y) - 0.5;
+	ivec2 luma_base = ivec2(floor(luma_pos));
+	vec2 luma_weight = luma_pos - vec2(luma_base);
+	float luma_top = mix(fetchLuma(luma_base, size), fetchLuma(luma_base + ivec2(1, 0), size), luma_weight.x);
+	float luma_bottom = mix(fetchLuma(luma_base + ivec2(0, 1), size), fetchLuma(luma_base + ivec2(1, 1), size), luma_weight.x);
+	float y = mix(luma_top, luma_bottom, luma_weight.y);
+
+	// Bilinear filter the chroma pairs, one per texel
+	vec2 pos = uvs * vec2(size) - 0.5;
+	ivec2 base = ivec2(floor(pos));
+	vec2 weight = pos - vec2(base);
+	vec2 top = mix(fetchTexel(base, size).zw, fetchTexel(base + ivec2(1, 0), size).zw, weight.x);
+	vec2 bottom = mix(fetchTexel(base + ivec2(0, 1), size).zw, fetchTexel(base + ivec2(1, 1), size).zw, weight.x);
+	vec2 chroma = mix(top, bottom, weight.y);
+
+	vec3 yuv = vec3(y, chroma) + offset;
+	out_Color = vec4(dot(yuv, R_cf), dot(yuv, G_cf), dot(yuv, B_cf), 1.0);
+}
@@ -6,10 +6,22 @@
 
 uniform sampler2D Texture;
 
+// Swaps red and blue when swapRedBlue is not 0 (BGRA), ignores the alpha channel when opaque is not 0 (RGB0, BGR0)
+uniform UBO
+{
+	int swapRedBlue;
+	int opaque;
+} ubo;
+
 in vec3 pass_Uvs;
 out vec4 out_Color;
 
 void main() 
 {
-	out_Color = texture(Texture, vec2(pass_Uvs.x, 1.0-pass_Uvs.y)).rgba;
+	vec4 color = texture(Texture, vec2(pass_Uvs.x, 1.0-pass_Uvs.y)).rgba;
+	if (ubo.swapRedBlue != 0)
+		color = color.bgra;
+	if (ubo.opaque != 0)
+		color.a = 1.0;
+	out_Color = color;
 }
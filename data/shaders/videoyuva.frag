@@ -0,0 +1,40 @@
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at https://mozilla.org/MPL/2.0/.
+
+#version 450 core
+
+uniform sampler2D yTexture;
+uniform sampler2D uTexture;
+uniform sampler2D vTexture;
+uniform sampler2D aTexture;
+
+// Normalizes samples stored in a wider texture format, (2^16-1) / (2^bits-1)
+// Outputs premultiplied alpha when premultiplyAlpha is not 0, straight alpha otherwise
+uniform UBO
+{
+	float sampleScale;
+	int premultiplyAlpha;
+} ubo;
+
+in vec3 pass_Uvs;
+out vec4 out_Color;
+
+// YUV to RGB conversion
+const vec3 R_cf = vec3(1.164383,  0.000000,  1.596027);
+const vec3 G_cf = vec3(1.164383, -0.391762, -0.812968);
+const vec3 B_cf = vec3(1.164383,  2.017232,  0.000000);
+const vec3 offset = vec3(-0.0625, -0.5, -0.5);
+
+void main() 
+{
+	vec2 uvs = vec2(pass_Uvs.x, 1.0-pass_Uvs.y);
+	vec3 yuv = vec3(texture(yTexture, uvs).r, texture(uTexture, uvs).r, texture(vTexture, uvs).r);
+	yuv = yuv * ubo.sampleScale + offset;
+	float alpha = clamp(texture(aTexture, uvs).r * ubo.sampleScale, 0.0, 1.0);
+
+	vec3 color = vec3(dot(yuv, R_cf), dot(yuv, G_cf), dot(yuv, B_cf));
+	if (ubo.premultiplyAlpha != 0)
+		color *= alpha;
+	out_Color = vec4(color, alpha);
+}
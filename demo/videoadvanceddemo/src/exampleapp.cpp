@@ -190,11 +190,14 @@ namespace nap
             {
                 mVideoPlayer1->seek(mSeek1 * mVideoPlayer1->getDuration());
             }
+            mVideoPlayer1->setScrubbing(ImGui::IsItemActive());
 
             if(ImGui::Button("Load Again"))
             {
                 mVideoPlayer1->loadVideo(mVideoPlayer1->mFilePath);
             }
+            ImGui::SameLine();
+            ImGui::Text("First frame after %.1f ms", mVideoPlayer1->getFirstFrameLatency() * 1000.0);
             ImGui::PopID();
 
             ImGui::PushID(2);
@@ -206,11 +209,14 @@ namespace nap
             {
                 mVideoPlayer2->seek(mSeek2 * mVideoPlayer2->getDuration());
             }
+            mVideoPlayer2->setScrubbing(ImGui::IsItemActive());
 
             if(ImGui::Button("Load Again"))
             {
                 mVideoPlayer2->loadVideo(mVideoPlayer2->mFilePath);
             }
+            ImGui::SameLine();
+            ImGui::Text("First frame after %.1f ms", mVideoPlayer2->getFirstFrameLatency() * 1000.0);
 
             ImGui::PopID();
 
@@ -223,11 +229,14 @@ namespace nap
             {
                 mVideoPlayer3->seek(mSeek3 * mVideoPlayer3->getDuration());
             }
+            mVideoPlayer3->setScrubbing(ImGui::IsItemActive());
 
             if(ImGui::Button("Load Again"))
             {
                 mVideoPlayer3->loadVideo(mVideoPlayer3->mFilePath);
             }
+            ImGui::SameLine();
+            ImGui::Text("First frame after %.1f ms", mVideoPlayer3->getFirstFrameLatency() * 1000.0);
 
             ImGui::PopID();
 
@@ -241,11 +250,14 @@ namespace nap
             {
                 mVideoPlayer4->seek(mSeek4 * mVideoPlayer4->getDuration());
             }
+            mVideoPlayer4->setScrubbing(ImGui::IsItemActive());
 
             if(ImGui::Button("Load Again"))
             {
                 mVideoPlayer4->loadVideo(mVideoPlayer4->mFilePath);
             }
+            ImGui::SameLine();
+            ImGui::Text("First frame after %.1f ms", mVideoPlayer4->getFirstFrameLatency() * 1000.0);
 
             ImGui::PopID();
 
@@ -258,11 +270,14 @@ namespace nap
             {
                 mVideoPlayer5->seek(mSeek5 * mVideoPlayer5->getDuration());
             }
+            mVideoPlayer5->setScrubbing(ImGui::IsItemActive());
 
             if(ImGui::Button("Load Again"))
             {
                 mVideoPlayer5->loadVideo(mVideoPlayer5->mFilePath);
             }
+            ImGui::SameLine();
+            ImGui::Text("First frame after %.1f ms", mVideoPlayer5->getFirstFrameLatency() * 1000.0);
 
             ImGui::PopID();
         }
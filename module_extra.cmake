@@ -0,0 +1,8 @@
+# Standalone scalar vs SIMD check and benchmark of the plane transforms, not built by default
+option(NAPVIDEOADVANCED_BUILD_CHECKS "Build the standalone plane transform check and benchmark" OFF)
+if(NAPVIDEOADVANCED_BUILD_CHECKS)
+    add_executable(videoplanetransformcheck ${CMAKE_CURRENT_LIST_DIR}/test/videoplanetransformcheck.cpp)
+    target_link_libraries(videoplanetransformcheck ${PROJECT_NAME})
+    set_target_properties(videoplanetransformcheck PROPERTIES FOLDER Tests)
+    add_test(NAME videoplanetransformcheck COMMAND videoplanetransformcheck --no-benchmark)
+endif()
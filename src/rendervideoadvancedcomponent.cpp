@@ -13,12 +13,24 @@
 #include <renderservice.h>
 #include <renderglobals.h>
 #include <glm/gtc/matrix_transform.hpp>
+#include <atomic>
+
+RTTI_BEGIN_ENUM(nap::EVideoGrayscaleOutput)
+        RTTI_ENUM_VALUE(nap::EVideoGrayscaleOutput::RGB,	"RGB"),
+        RTTI_ENUM_VALUE(nap::EVideoGrayscaleOutput::Red,	"Red"),
+        RTTI_ENUM_VALUE(nap::EVideoGrayscaleOutput::Green,	"Green"),
+        RTTI_ENUM_VALUE(nap::EVideoGrayscaleOutput::Blue,	"Blue"),
+        RTTI_ENUM_VALUE(nap::EVideoGrayscaleOutput::Alpha,	"Alpha")
+RTTI_END_ENUM
 
 RTTI_BEGIN_CLASS(nap::RenderVideoAdvancedComponent)
         RTTI_PROPERTY("OutputTexture",	&nap::RenderVideoAdvancedComponent::mOutputTexture,			nap::rtti::EPropertyMetaData::Required,	"The texture to render output to")
         RTTI_PROPERTY("VideoPlayer",	&nap::RenderVideoAdvancedComponent::mVideoPlayer,			nap::rtti::EPropertyMetaData::Required, "The video player to render to texture")
         RTTI_PROPERTY("Samples",		&nap::RenderVideoAdvancedComponent::mRequestedSamples,		nap::rtti::EPropertyMetaData::Default,	"The number of rasterization samples")
+        RTTI_PROPERTY("SampleShading",	&nap::RenderVideoAdvancedComponent::mSampleShading,			nap::rtti::EPropertyMetaData::Default,	"Shade every sample when 'Samples' is above one, disable to shade once per pixel")
         RTTI_PROPERTY("ClearColor",		&nap::RenderVideoAdvancedComponent::mClearColor,			nap::rtti::EPropertyMetaData::Default,	"Initial target clear color")
+        RTTI_PROPERTY("PremultiplyAlpha",	&nap::RenderVideoAdvancedComponent::mPremultiplyAlpha,		nap::rtti::EPropertyMetaData::Default,	"Output premultiplied alpha for video formats that carry alpha, straight alpha otherwise")
+        RTTI_PROPERTY("GrayscaleOutput",	&nap::RenderVideoAdvancedComponent::mGrayscaleOutput,		nap::rtti::EPropertyMetaData::Default,	"Output channel of grayscale video formats, RGB replicates the value")
 RTTI_END_CLASS
 
 RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::RenderVideoAdvancedComponentInstance)
@@ -30,6 +42,12 @@ RTTI_END_CLASS
 
 namespace nap
 {
+    // Weight of the last frame in the conversion time average
+    static constexpr double sConversionTimeWeight = 0.05;
+
+    // ID of the next component, 0 means no component wrote the handler uniforms
+    static std::atomic<uint64> sNextUniformOwnerID = { 1 };
+
     /**
      * Creates a model matrix based on the dimensions of the given target.
      */
@@ -51,7 +69,21 @@ namespace nap
             RenderableComponentInstance(entity, resource),
             mTarget(*entity.getCore()),
             mPlane(*entity.getCore()),
-            mRenderService(entity.getCore()->getService<RenderService>()){ }
+            mRenderService(entity.getCore()->getService<RenderService>()),
+            mUniformOwnerID(sNextUniformOwnerID.fetch_add(1)) { }
+
+
+    RenderVideoAdvancedComponentInstance::~RenderVideoAdvancedComponentInstance()
+    {
+        if (mTimestampQueries == VK_NULL_HANDLE)
+            return;
+
+        VkQueryPool query_pool = mTimestampQueries;
+        mRenderService->queueVulkanObjectDestructor([query_pool](RenderService& renderService)
+        {
+            vkDestroyQueryPool(renderService.getDevice(), query_pool, nullptr);
+        });
+    }
 
 
     bool RenderVideoAdvancedComponentInstance::init(utility::ErrorState& errorState)
@@ -75,10 +107,14 @@ namespace nap
         if (!errorState.check(mOutputTexture->mColorFormat == RenderTexture2D::EFormat::RGBA8, "%s: output texture color format is not RGBA8", resource->mID.c_str()))
             return false;
 
-        // Setup render target and initialize
+        mPremultiplyAlpha = resource->mPremultiplyAlpha;
+        mGrayscaleOutput = resource->mGrayscaleOutput;
+
+        // Setup render target and initialize.
+        // Shading once per pixel is cheaper with multiple samples, but UVs are no longer interpolated per sample
         mTarget.mClearColor = resource->mClearColor.convert<RGBAColorFloat>();
         mTarget.mColorTexture  = resource->mOutputTexture;
-        mTarget.mSampleShading = true;
+        mTarget.mSampleShading = resource->mSampleShading;
         mTarget.mRequestedSamples = resource->mRequestedSamples;
         if (!mTarget.init(errorState))
             return false;
@@ -95,6 +131,26 @@ namespace nap
         if (!mPlane.init(errorState))
             return false;
 
+        // Timestamp queries that measure the conversion pass, optional
+        const VkPhysicalDeviceProperties& properties = mRenderService->getPhysicalDeviceProperties();
+        if (properties.limits.timestampComputeAndGraphics == VK_TRUE)
+        {
+            int frame_count = mRenderService->getMaxFramesInFlight();
+            VkQueryPoolCreateInfo query_info = {};
+            query_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            query_info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            query_info.queryCount = static_cast<uint32>(frame_count * 2);
+            if (vkCreateQueryPool(mRenderService->getDevice(), &query_info, nullptr, &mTimestampQueries) == VK_SUCCESS)
+            {
+                mTimestampsWritten.assign(frame_count, false);
+                mTimestampPeriod = static_cast<double>(properties.limits.timestampPeriod) * 1.0e-9;
+            }
+            else
+            {
+                mTimestampQueries = VK_NULL_HANDLE;
+            }
+        }
+
         // Register for pixel format handler changes
         mPlayer->onPixelFormatHandlerChanged.connect(mPixelFormatHandlerChangedSlot);
         if(mPlayer->hasPixelFormatHandler())
@@ -116,6 +172,10 @@ namespace nap
             return;
         }
 
+        // The pipeline and uniforms are resolved again for the new handler
+        mDrawnGeneration = 0;
+        mPipeline = RenderService::Pipeline();
+        mPipelineTarget = nullptr;
         mValid = true;
     }
 
@@ -137,6 +197,12 @@ namespace nap
         if(!mValid)
             return;
 
+        // The output already holds the current frame: paused, a lower frame rate than the app or nothing uploaded
+        auto& pixel_format_handler = mPlayer->getPixelFormatHandler();
+        if(pixel_format_handler.getFrameGeneration() == mDrawnGeneration)
+            return;
+        mDrawnGeneration = pixel_format_handler.getFrameGeneration();
+
         // Get current command buffer, should be headless.
         VkCommandBuffer command_buffer = mRenderService->getCurrentCommandBuffer();
 
@@ -146,38 +212,97 @@ namespace nap
         // Create projection matrix
         glm::mat4 proj_matrix = OrthoCameraComponentInstance::createRenderProjectionMatrix(0.0f, (float)size.x, 0.0f, (float)size.y);
 
+        // Copy the frame staged by the decode worker to the video textures, outside of the render pass
+        pixel_format_handler.recordUpload(command_buffer);
+
+        // Read the conversion time of the last frame that used these frame in flight resources, the GPU finished it
+        uint32 first_query = 0;
+        if (mTimestampQueries != VK_NULL_HANDLE)
+        {
+            int frame_index = mRenderService->getCurrentFrameIndex();
+            first_query = static_cast<uint32>(frame_index * 2);
+            uint64 timestamps[2] = { 0, 0 };
+            if (mTimestampsWritten[frame_index] && vkGetQueryPoolResults(mRenderService->getDevice(), mTimestampQueries, first_query, 2,
+                sizeof(timestamps), timestamps, sizeof(uint64), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS && timestamps[1] >= timestamps[0])
+            {
+                double conversion_time = static_cast<double>(timestamps[1] - timestamps[0]) * mTimestampPeriod;
+                mConversionTime = mConversionTime > 0.0 ? mConversionTime + (conversion_time - mConversionTime) * sConversionTimeWeight : conversion_time;
+            }
+
+            vkCmdResetQueryPool(command_buffer, mTimestampQueries, first_query, 2);
+            vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, mTimestampQueries, first_query);
+            mTimestampsWritten[frame_index] = true;
+        }
+
         // Call on draw
         mTarget.beginRendering();
         onDraw(mTarget, command_buffer, glm::mat4(), proj_matrix);
         mTarget.endRendering();
+
+        if (mTimestampQueries != VK_NULL_HANDLE)
+            vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, mTimestampQueries, first_query + 1);
     }
 
 
     void RenderVideoAdvancedComponentInstance::onDraw(IRenderTarget& renderTarget, VkCommandBuffer commandBuffer, const glm::mat4& viewMatrix, const glm::mat4& projectionMatrix)
     {
-        //
         auto& pixel_format_handler = mPlayer->getPixelFormatHandler();
 
+        // Resolve the pipeline once per target and handler, a handler change or resize resolves it again.
+        // Other components can write the uniforms of a shared handler, all of them are written again when they did
+        glm::ivec2 target_size = renderTarget.getBufferSize();
+        bool owner = pixel_format_handler.mUniformOwner == mUniformOwnerID;
+        bool target_changed = &renderTarget != mPipelineTarget || target_size != mPipelineTargetSize;
+        if (target_changed || mPipeline.mPipeline == VK_NULL_HANDLE)
+        {
+            utility::ErrorState error_state;
+            mPipeline = mRenderService->getOrCreatePipeline(renderTarget, mRenderableMesh.getMesh(), pixel_format_handler.mMaterialInstance, error_state);
+            if (mPipeline.mPipeline == VK_NULL_HANDLE)
+            {
+                nap::Logger::error("%s: Unable to create pipeline: %s", mID.c_str(), error_state.toString().c_str());
+                return;
+            }
+            mPipelineTarget = &renderTarget;
+            mPipelineTargetSize = target_size;
+        }
+
         // Update the model matrix so that the plane mesh is of the same size as the render target
-        computeModelMatrix(renderTarget, pixel_format_handler.mModelMatrix);
-        pixel_format_handler.mModelMatrixUniform->setValue(pixel_format_handler.mModelMatrix);
+        if (target_changed || !owner)
+        {
+            computeModelMatrix(renderTarget, pixel_format_handler.mModelMatrix);
+            pixel_format_handler.mModelMatrixUniform->setValue(pixel_format_handler.mModelMatrix);
+        }
 
         // Update matrices, projection and model are required
-        pixel_format_handler.mProjectMatrixUniform->setValue(projectionMatrix);
-        pixel_format_handler.mViewMatrixUniform->setValue(viewMatrix);
+        if (!owner || projectionMatrix != mProjectionMatrix || viewMatrix != mViewMatrix)
+        {
+            pixel_format_handler.mProjectMatrixUniform->setValue(projectionMatrix);
+            pixel_format_handler.mViewMatrixUniform->setValue(viewMatrix);
+            mProjectionMatrix = projectionMatrix;
+            mViewMatrix = viewMatrix;
+        }
+
+        if (!owner)
+        {
+            // Select straight or premultiplied output for formats that carry alpha
+            if (pixel_format_handler.mPremultiplyAlphaUniform != nullptr)
+                pixel_format_handler.mPremultiplyAlphaUniform->setValue(mPremultiplyAlpha ? 1 : 0);
+
+            // Select the output channel of grayscale formats
+            if (pixel_format_handler.mGrayscaleOutputUniform != nullptr)
+                pixel_format_handler.mGrayscaleOutputUniform->setValue(static_cast<int>(mGrayscaleOutput));
+            pixel_format_handler.mUniformOwner = mUniformOwnerID;
+        }
 
-        // Get valid descriptor set
+        // Get valid descriptor set, the uniform buffers and descriptor sets are per frame in flight: update every draw
         const DescriptorSet& descriptor_set = pixel_format_handler.mMaterialInstance.update();
 
         // Gather draw info
         MeshInstance& mesh_instance = mRenderableMesh.getMesh().getMeshInstance();
         GPUMesh& mesh = mesh_instance.getGPUMesh();
 
-        // Get pipeline to to render with
-        utility::ErrorState error_state;
-        RenderService::Pipeline pipeline = mRenderService->getOrCreatePipeline(renderTarget, mRenderableMesh.getMesh(), pixel_format_handler.mMaterialInstance, error_state);
-        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.mPipeline);
-        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.mLayout, 0, 1, &descriptor_set.mSet, 0, nullptr);
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipeline.mPipeline);
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mPipeline.mLayout, 0, 1, &descriptor_set.mSet, 0, nullptr);
 
         // Bind buffers and draw
         const std::vector<VkBuffer>& vertexBuffers = mRenderableMesh.getVertexBuffers();
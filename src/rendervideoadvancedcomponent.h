@@ -17,12 +17,26 @@
 #include <color.h>
 #include <materialinstance.h>
 #include <renderablemesh.h>
+#include <renderservice.h>
+#include <vector>
 
 namespace nap
 {
     // Forward Declares
     class RenderVideoAdvancedComponentInstance;
 
+    /**
+     * Output of grayscale video formats: the value replicated to RGB, or written to a single channel
+     */
+    enum class EVideoGrayscaleOutput : int
+    {
+        RGB     = 0,        ///< Value replicated to red, green and blue, opaque
+        Red     = 1,        ///< Value in red only, opaque
+        Green   = 2,        ///< Value in green only, opaque
+        Blue    = 3,        ///< Value in blue only, opaque
+        Alpha   = 4         ///< Value in alpha only, black
+    };
+
     class NAPAPI RenderVideoAdvancedComponent : public RenderableComponent
     {
     RTTI_ENABLE(RenderableComponent)
@@ -31,7 +45,10 @@ namespace nap
         ResourcePtr<VideoPlayerAdvancedBase>		mVideoPlayer = nullptr;								///< Property: 'VideoPlayer' the video player to render to texture
         ResourcePtr<RenderTexture2D>	            mOutputTexture = nullptr;							///< Property: 'OutputTexture' the RGB8 texture to render output to
         ERasterizationSamples			            mRequestedSamples = ERasterizationSamples::One;		///< Property: 'Samples' The number of samples used during Rasterization. For better results enable 'SampleShading'
+        bool                                        mSampleShading = true;                              ///< Property: 'SampleShading' shade every sample when 'Samples' is above one, disable to shade once per pixel
         RGBAColor8						            mClearColor = { 255, 255, 255, 255 };				///< Property: 'ClearColor' the color that is used to clear the render target
+        bool                                        mPremultiplyAlpha = false;                          ///< Property: 'PremultiplyAlpha' output premultiplied instead of straight alpha for formats that carry alpha
+        EVideoGrayscaleOutput                       mGrayscaleOutput = EVideoGrayscaleOutput::RGB;      ///< Property: 'GrayscaleOutput' output channel of grayscale formats
     };
 
 
@@ -41,6 +58,11 @@ namespace nap
     public:
         RenderVideoAdvancedComponentInstance(EntityInstance& entity, Component& resource);
 
+        /**
+         * Destroys the timestamp queries when the GPU no longer uses them
+         */
+        virtual ~RenderVideoAdvancedComponentInstance() override;
+
         /**
          * Initializes the component based on resource.
          * @param errorState contains the error if initialization fails.
@@ -66,9 +88,25 @@ namespace nap
          * nap::RenderService::endHeadlessRecording(). Do not call this function outside
          * of a headless recording pass, ie: when rendering to a window.
          * Alternatively, you can use the render service to render this component, see onDraw()
+         * Frames staged by the decode worker of a threaded player are only uploaded by this call, when the component
+         * is only rendered with onDraw() the player uploads frames on the main thread.
+         * Nothing is recorded when the output texture already holds the current frame of the player, see forceRedraw().
          */
         void draw();
 
+        /**
+         * Returns the GPU time of the conversion pass recorded by draw(), averaged over recent frames.
+         * Measured with timestamp queries, the result of a frame is available once the GPU finished it.
+         * @return the average GPU conversion time in seconds, 0 when the device doesn't support timestamps
+         */
+        double getConversionTime() const { return mConversionTime; }
+
+        /**
+         * Makes the next draw() convert the textures of the player, even when they hold the frame that was converted last.
+         * Call when the output texture was overwritten by something else.
+         */
+        void forceRedraw() { mDrawnGeneration = 0; }
+
     protected:
         /**
          * Draws the video frame full screen to the currently active render target,
@@ -90,6 +128,19 @@ namespace nap
         RenderService*				mRenderService = nullptr;						///< Pointer to the render service
         bool						mDirty = true;									///< If the model matrix needs to be re-computed
         bool                        mValid = false;                                 ///< If the component is valid
+        bool                        mPremultiplyAlpha = false;                      ///< If formats that carry alpha output premultiplied alpha
+        EVideoGrayscaleOutput       mGrayscaleOutput = EVideoGrayscaleOutput::RGB;  ///< Output channel of grayscale formats
+        VkQueryPool                 mTimestampQueries = VK_NULL_HANDLE;             ///< Begin and end timestamp of the conversion pass, per frame in flight
+        std::vector<bool>           mTimestampsWritten;                             ///< If the timestamps of a frame in flight were recorded
+        double                      mTimestampPeriod = 0.0;                         ///< Seconds per timestamp tick
+        double                      mConversionTime = 0.0;                          ///< Average GPU conversion time in seconds
+        uint64                      mDrawnGeneration = 0;                           ///< Frame generation of the handler in the output texture, 0 when none
+        RenderService::Pipeline     mPipeline;                                      ///< Pipeline resolved for the cached target and handler
+        const IRenderTarget*        mPipelineTarget = nullptr;                      ///< Target the pipeline and model matrix were resolved for
+        glm::ivec2                  mPipelineTargetSize = { 0, 0 };                 ///< Size of the target the model matrix was computed for
+        glm::mat4                   mViewMatrix;                                    ///< View matrix last written to the handler
+        glm::mat4                   mProjectionMatrix;                              ///< Projection matrix last written to the handler
+        uint64                      mUniformOwnerID = 0;                            ///< Identifies the writer of the handler uniforms, never reused by another component
 
         void onPixelFormatHandlerChanged(VideoPixelFormatHandlerBase& pixelFormatHandler);
         Slot<VideoPixelFormatHandlerBase&> mPixelFormatHandlerChangedSlot = { this, &RenderVideoAdvancedComponentInstance::onPixelFormatHandlerChanged };
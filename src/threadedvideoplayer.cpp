@@ -8,12 +8,19 @@
 // Local Includes
 #include "videoservice.h"
 #include "videoadvancedservice.h"
+#include "videokeyframeindex.h"
+#include "videostagingring.h"
+#include "videoformatconverter.h"
+#include "videoplanetransform.h"
 
 // External Includes
-#include <mathutils.h>
 #include <nap/assert.h>
 #include <libavformat/avformat.h>
+#include <libavutil/pixdesc.h>
 #include <nap/core.h>
+#include <renderservice.h>
+#include <algorithm>
+#include <cmath>
 
 
 RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::ThreadedVideoPlayer)
@@ -21,6 +28,11 @@ RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::ThreadedVideoPlayer)
         RTTI_PROPERTY("Loop", &nap::ThreadedVideoPlayer::mLoop, nap::rtti::EPropertyMetaData::Default, "Loop the selected video")
         RTTI_PROPERTY("FilePath", &nap::ThreadedVideoPlayer::mFilePath, nap::rtti::EPropertyMetaData::Default | nap::rtti::EPropertyMetaData::FileLink, "Path to the video file, leave empty to not load file on init")
         RTTI_PROPERTY("Speed", &nap::ThreadedVideoPlayer::mSpeed, nap::rtti::EPropertyMetaData::Default, "Video playback speed")
+        RTTI_PROPERTY("DecodeAheadFrames", &nap::ThreadedVideoPlayer::mDecodeAheadFrames, nap::rtti::EPropertyMetaData::Default, "Number of frames the worker decodes ahead of presentation")
+        RTTI_PROPERTY("BuildKeyframeIndex", &nap::ThreadedVideoPlayer::mBuildKeyframeIndex, nap::rtti::EPropertyMetaData::Default, "Build or load a keyframe index in the background when a video is loaded")
+        RTTI_PROPERTY("StagedUpload", &nap::ThreadedVideoPlayer::mStagedUpload, nap::rtti::EPropertyMetaData::Default, "Copy frames to staging buffers on the worker, the main thread only records the texture copies")
+        RTTI_PROPERTY("ReduceBitDepth", &nap::ThreadedVideoPlayer::mReduceBitDepth, nap::rtti::EPropertyMetaData::Default, "Dither samples of more than 8 bits to 8 bits on the worker, the render output is 8 bits per channel")
+        RTTI_PROPERTY("InterleaveChroma", &nap::ThreadedVideoPlayer::mInterleaveChroma, nap::rtti::EPropertyMetaData::Default, "Interleave planar 4:2:0 chroma on the worker, uploads two textures per frame instead of three")
 RTTI_END_CLASS
 
 //////////////////////////////////////////////////////////////////////////
@@ -28,12 +40,197 @@ RTTI_END_CLASS
 
 namespace nap
 {
+    // Delay between work cycles when the decoder has no frame available yet
+    static constexpr double sDecoderPollInterval = 0.002;
+
+    // Max number of frames decoded and discarded per work cycle when seeking to an exact frame
+    static constexpr int sExactSeekFramesPerCycle = 16;
+
+    // Number of packets read per keyframe index build task
+    static constexpr int sKeyframeIndexBatchSize = 256;
+
+    // Delay between keyframe index build tasks, gives decode work priority
+    static constexpr double sKeyframeIndexBatchInterval = 0.001;
+
+    // Max time the clock of a pre-rolled video runs ahead of its in point while waiting for the first frame
+    static constexpr double sPrerollMaxClockLead = 0.05;
+
+    // Time in seconds before the end of an entry the loop head of the same file is pre-rolled,
+    // the second decoder of a looping video is only open while the tail plays
+    static constexpr double sLoopPrerollLead = 2.0;
+
     struct ThreadedVideoPlayer::Impl
     {
     public:
-        moodycamel::ConcurrentQueue<Frame> mFrames;
+        /**
+         * Keyframe index of a video, built or loaded in the background.
+         * Shared with the build tasks, which can outlive the video.
+         */
+        struct KeyframeIndex
+        {
+            VideoKeyframeIndex mIndex;                  ///< Only accessed by the build tasks until ready, immutable afterwards
+            std::string mPath;                          ///< Path of the video file
+            std::string mCachePath;                     ///< Path of the cache file
+            bool mBuilding = false;                     ///< If the video file is opened for building, build tasks only
+            std::atomic_bool mReady = { false };        ///< If the index is complete
+            std::atomic_bool mCancelled = { false };    ///< Stops the build tasks
+        };
+
+        /**
+         * Loads the index from the cache file, or builds it one batch of packets per task.
+         * @param pool the pool to schedule the next batch on
+         * @param index the index to load or build
+         */
+        static void buildKeyframeIndex(VideoWorkerPool& pool, std::shared_ptr<KeyframeIndex> index);
+
+        /**
+         * Playlist entry that is opened and decoded to its first frame in the background.
+         * Shared with the pre-roll tasks, which can outlive the playlist.
+         */
+        struct Preroll
+        {
+            ~Preroll()                                  { mFirstFrame.free(); }
+
+            std::unique_ptr<Video> mVideo;              ///< Only accessed by the pre-roll tasks until ready, by the worker afterwards
+            Frame mFirstFrame;                          ///< First decoded frame of the entry
+            std::string mPath;                          ///< Path of the video file
+            double mInPoint = 0.0;                      ///< Time in seconds to start playback at
+            float mSpeed = 1.0f;                        ///< Playback speed
+            int mNumThreads = 0;                        ///< Number of decode threads
+            int mIndex = -1;                            ///< Playlist index of the entry
+            double mClockLead = 0.0;                    ///< Time the clock of the video was advanced while waiting for the first frame
+            std::atomic_bool mReady = { false };        ///< If the first frame is decoded
+            std::atomic_bool mFailed = { false };       ///< If the video can't be opened or played
+            std::atomic_bool mCancelled = { false };    ///< Stops the pre-roll tasks
+        };
+
+        /**
+         * Opens the video of a playlist entry and polls it until the first frame is decoded, one poll per task.
+         * @param pool the pool to schedule the next poll on
+         * @param preroll the entry to pre-roll
+         */
+        static void prerollVideo(VideoWorkerPool& pool, std::shared_ptr<Preroll> preroll);
+
+        /**
+         * Cancels and releases the pre-roll in flight, worker only
+         */
+        void cancelPreroll();
+
+        VideoFrameRing mFrames;
+        std::unique_ptr<VideoStagingRing> mStaging;     ///< Staging buffers of decoded frames, nullptr when uploading on the main thread
+        std::unique_ptr<VideoFormatConverter> mConverter;   ///< Converts frames of unsupported pixel formats, worker only
+        int mDecodedFormat = -1;                        ///< Pixel format of the last decoded frame, worker only
+        int mUploadFormat = -1;                         ///< Pixel format the decoded format is converted to, worker only
+        int mTransformFormat = -1;                      ///< Pixel format the upload format is staged as, worker only
+        std::shared_ptr<KeyframeIndex> mKeyframeIndex;  ///< Keyframe index of the current video, worker only
+        std::shared_ptr<Preroll> mPreroll;              ///< Pre-roll of the next playlist entry, worker only
     };
 
+
+    void ThreadedVideoPlayer::Impl::buildKeyframeIndex(VideoWorkerPool& pool, std::shared_ptr<KeyframeIndex> index)
+    {
+        if(index->mCancelled)
+            return;
+
+        // Use the cache file when it's up to date, otherwise open the video file for building
+        if(!index->mBuilding)
+        {
+            utility::ErrorState cache_error;
+            if(index->mIndex.load(index->mCachePath, index->mPath, cache_error))
+            {
+                index->mReady = true;
+                return;
+            }
+
+            utility::ErrorState error;
+            if(!index->mIndex.open(index->mPath, error))
+            {
+                nap::Logger::warn("Unable to build keyframe index: %s", error.toString().c_str());
+                return;
+            }
+            index->mBuilding = true;
+        }
+
+        // Read the next batch, continue in a new task to not block the worker
+        bool finished = false;
+        if(!index->mIndex.build(sKeyframeIndexBatchSize, finished))
+        {
+            nap::Logger::warn("Unable to build keyframe index for file: %s", index->mPath.c_str());
+            return;
+        }
+
+        if(!finished)
+        {
+            auto due = SteadyClock::now() + std::chrono::duration_cast<SteadyClock::duration>(std::chrono::duration<double>(sKeyframeIndexBatchInterval));
+            pool.enqueueAt(due, [&pool, index]() { buildKeyframeIndex(pool, index); });
+            return;
+        }
+
+        utility::ErrorState error;
+        if(!index->mIndex.save(index->mCachePath, error))
+            nap::Logger::warn("Unable to save keyframe index: %s", error.toString().c_str());
+        index->mReady = true;
+    }
+
+
+    void ThreadedVideoPlayer::Impl::prerollVideo(VideoWorkerPool& pool, std::shared_ptr<Preroll> preroll)
+    {
+        if(preroll->mCancelled)
+            return;
+
+        // Open the video and start decoding at the in point
+        if(preroll->mVideo == nullptr)
+        {
+            utility::ErrorState error;
+            auto video = std::make_unique<nap::Video>(preroll->mPath, preroll->mNumThreads);
+            if(!video->init(error))
+            {
+                nap::Logger::error("Unable to pre-roll video for file: %s", preroll->mPath.c_str());
+                preroll->mFailed = true;
+                return;
+            }
+
+            video->mLoop = false;
+            video->mSpeed = preroll->mSpeed;
+            video->play(preroll->mInPoint);
+            preroll->mVideo = std::move(video);
+        }
+
+        // Poll for the first frame, the clock of the video only runs ahead of the in point a little
+        // to let a first frame that starts just after the in point through
+        double step = std::min(sDecoderPollInterval, sPrerollMaxClockLead - preroll->mClockLead);
+        Frame frame = preroll->mVideo->update(std::max(step, 0.0));
+        preroll->mClockLead += std::max(step, 0.0);
+        if(frame.isValid())
+        {
+            preroll->mFirstFrame = frame;
+            preroll->mReady = true;
+            return;
+        }
+
+        frame.free();
+        if(!preroll->mVideo->isPlaying())
+        {
+            nap::Logger::error("Unable to pre-roll video for file: %s", preroll->mPath.c_str());
+            preroll->mFailed = true;
+            return;
+        }
+
+        auto due = SteadyClock::now() + std::chrono::duration_cast<SteadyClock::duration>(std::chrono::duration<double>(sDecoderPollInterval));
+        pool.enqueueAt(due, [&pool, preroll]() { prerollVideo(pool, preroll); });
+    }
+
+
+    void ThreadedVideoPlayer::Impl::cancelPreroll()
+    {
+        if(mPreroll != nullptr)
+        {
+            mPreroll->mCancelled = true;
+            mPreroll = nullptr;
+        }
+    }
+
+
     ThreadedVideoPlayer::ThreadedVideoPlayer(VideoAdvancedService& service) :
             VideoPlayerAdvancedBase(service)
     { }
@@ -68,7 +265,7 @@ namespace nap
         if (!mVideoLoaded)
             return 0.0;
 
-        return mDuration;
+        return mPlaybackState.load().mDuration;
     }
 
 
@@ -90,6 +287,12 @@ namespace nap
     }
 
 
+    VideoPlaybackState ThreadedVideoPlayer::getPlaybackState() const
+    {
+        return mPlaybackState.load();
+    }
+
+
     bool ThreadedVideoPlayer::hasAudio() const
     {
         return mHasAudio;
@@ -101,11 +304,35 @@ namespace nap
         if (!mVideoLoaded)
             return;
 
-        enqueueWorkTask([this, seconds]()
-        {
-            if(mCurrentVideo != nullptr)
-                mCurrentVideo->seek(seconds);
-        });
+        // Latest wins, the worker only executes the most recent target
+        mSeekTarget.store(seconds);
+        mSeekFrame.store(-1);
+        mSeekSequence.fetch_add(1);
+        scheduleWork();
+    }
+
+
+    void ThreadedVideoPlayer::seekToFrame(int64 frame)
+    {
+        if(!mVideoLoaded)
+            return;
+
+        // Coalesced with time based seeks, the sequence is incremented last
+        mSeekFrame.store(std::max<int64>(frame, 0));
+        mSeekSequence.fetch_add(1);
+        scheduleWork();
+    }
+
+
+    void ThreadedVideoPlayer::setScrubbing(bool value)
+    {
+        mScrubbing = value;
+    }
+
+
+    bool ThreadedVideoPlayer::isScrubbing() const
+    {
+        return mScrubbing;
     }
 
 
@@ -119,14 +346,95 @@ namespace nap
 
 
     void ThreadedVideoPlayer::loadVideo(const std::string& path)
+    {
+        // A regular load ends playlist playback
+        enqueueWorkTask([this]()
+        {
+            mImpl->cancelPreroll();
+            mPlaylist.clear();
+            mPlaylistIndex = -1;
+        });
+        load(path);
+    }
+
+
+    void ThreadedVideoPlayer::setPlaylist(const std::vector<VideoPlaylistEntry>& entries)
+    {
+        if(entries.empty())
+        {
+            clearPlaylist();
+            return;
+        }
+
+        // The first entry is loaded as a regular video, the next entry is pre-rolled once it's loaded
+        enqueueWorkTask([this, entries]()
+        {
+            mImpl->cancelPreroll();
+            mPlaylist = entries;
+            mPlaylistIndex = 0;
+        });
+        load(entries.front().mPath);
+    }
+
+
+    void ThreadedVideoPlayer::clearPlaylist()
+    {
+        enqueueWorkTask([this]()
+        {
+            mImpl->cancelPreroll();
+            mPlaylist.clear();
+            mPlaylistIndex = -1;
+            if(mCurrentVideo != nullptr)
+                prerollNextEntry();
+        });
+    }
+
+
+    void ThreadedVideoPlayer::setLoopSegment(double inPoint, double outPoint)
+    {
+        enqueueWorkTask([this, inPoint, outPoint]()
+        {
+            mSegmentInPoint = std::max(inPoint, 0.0);
+            mSegmentOutPoint = outPoint;
+            if(mCurrentVideo != nullptr)
+                prerollNextEntry();
+        });
+    }
+
+
+    void ThreadedVideoPlayer::clearLoopSegment()
+    {
+        setLoopSegment(0.0, -1.0);
+    }
+
+
+    void ThreadedVideoPlayer::load(const std::string& path)
     {
         // current video is not loaded
         // if a video is loaded will be stopped and unloaded in the next cycle of the worker thread
         mVideoLoaded = false;
+        beginLoad();
 
-        enqueueWorkTask([this, path]()
+        // Known file: set up the pixel format handler before the decoder is opened
+        VideoProbe probe;
+        bool cached = mService.getProbeCache().find(path, probe);
+        if(cached)
         {
             utility::ErrorState error;
+            int upload_format = utility::getVideoConversionFormat(probe.mPixelFormat);
+            if(upload_format >= 0)
+                upload_format = utility::getVideoTransformFormat(upload_format, mReduceBitDepth, mInterleaveChroma);
+            if(upload_format >= 0 && !preparePixelFormatHandler(upload_format, { probe.mWidth, probe.mHeight }, error))
+                nap::Logger::warn("%s: %s", mID.c_str(), error.toString().c_str());
+        }
+
+        uint32 seek_sequence = mSeekSequence.load();
+        enqueueWorkTask([this, path, seek_sequence, cached]()
+        {
+            utility::ErrorState error;
+
+            // seeks issued before the load don't apply to the new video
+            discardSeeks(seek_sequence);
 
             // stop current video
             if(mCurrentVideo!= nullptr)
@@ -134,20 +442,20 @@ namespace nap
 
             // delete current video
             mCurrentVideo = nullptr;
-
-            // Load video and initialize
-            auto new_video_file = std::make_unique<nap::VideoFile>();
-            new_video_file->mPath = path;
-            new_video_file->mID = math::generateUUID();
-            if(!new_video_file->init(error))
-            {
-                nap::Logger::error("%s: Unable to load video for file: %s", mID.c_str(), path.c_str());
-                return;
-            }
-
-            // VideoFile has valid path & pixel format
-            // Proceed to load video
-            auto new_video = std::make_unique<nap::Video>(new_video_file->mPath, mNumThreads);
+            mWorkerState = VideoPlaybackState();
+            mExactSeekTarget = -1.0;
+            mMeasureSeek = false;
+            mVideoPath = path;
+            mCacheProbe = !cached;
+            mSegmentInPoint = 0.0;
+            mSegmentOutPoint = -1.0;
+            mEntryStarted = false;
+            mEntryFinished = false;
+            mImpl->mDecodedFormat = -1;
+            flushFrames();
+
+            // Open and probe the file once, the pixel format is taken from the first decoded frame
+            auto new_video = std::make_unique<nap::Video>(path, mNumThreads);
             if(!new_video->init(error))
             {
                 nap::Logger::error("%s: Unable to load video for file: %s", mID.c_str(), path.c_str());
@@ -157,115 +465,22 @@ namespace nap
             // Update selection
             mCurrentVideo = new_video.get();
 
-            // Copy properties for playback
-            mCurrentVideo->mLoop  = mLoop;
-            mCurrentVideo->mSpeed = mSpeed;
+            // Copy properties for playback, looping is handled by the player: the loop head is pre-rolled
+            mCurrentVideo->mLoop  = false;
+            mCurrentVideo->mSpeed = mSpeedTarget.load();
 
             glm::vec2 size = { mCurrentVideo->getWidth(), mCurrentVideo->getHeight() };
 
             mVideo = std::move(new_video);
+            mWorkerState.mDuration = mCurrentVideo->getDuration();
+            loadKeyframeIndex(path);
+            prerollNextEntry();
 
             // copy some properties to the main thread
-            double duration = mCurrentVideo->getDuration(); // get duration
             bool has_audio = mCurrentVideo->hasAudio(); // check if video has audio
-            int pix_fmt = new_video_file->getPixelFormat(); // get pixel format
-
-            // proceed creating pixel format handler on main thread if necessary
-            enqueueMainTask([this, duration, size, has_audio, pix_fmt]()
+            enqueueMainTask([this, size, has_audio]()
             {
-                // error state
-                utility::ErrorState error;
-
-                // pixel handler unique & raw pointer
-                std::unique_ptr<VideoPixelFormatHandlerBase> new_pixel_format_handler = nullptr;
-                VideoPixelFormatHandlerBase* pixel_format_handler_ptr = nullptr;
-
-                // determine if we need to create a new pixel format handler
-                // either the current pixel format handler is null or the pixel format is different
-                // in that case, we need to create a new pixel format handler
-                bool create_new_pixel_format_handler = false;
-                if(mPixelFormatHandler!= nullptr)
-                {
-                    rtti::TypeInfo pixel_format_handler_type = mPixelFormatHandler->get_type();
-                    if(utility::getVideoPixelFormatHandlerType(pix_fmt, pixel_format_handler_type, error))
-                    {
-                        if(pixel_format_handler_type != mPixelFormatHandler->get_type())
-                            create_new_pixel_format_handler = true;
-                    }
-                }else
-                {
-                    create_new_pixel_format_handler = true;
-                }
-
-                // if we need to create a new pixel format handler proceed doing so
-                if(create_new_pixel_format_handler)
-                {
-                    // create the new pixel handler and initialize it, if it fails, stop the video on worker thread
-                    // and delete it
-                    new_pixel_format_handler = utility::createVideoPixelFormatHandler(pix_fmt, mService, error);
-                    if(new_pixel_format_handler == nullptr)
-                    {
-                        nap::Logger::error("%s: Unable to create pixel format handler", mID.c_str());
-
-                        enqueueWorkTask([this]()
-                        {
-                            mCurrentVideo = nullptr;
-                            mVideo = nullptr;
-                        });
-
-                        return;
-                    }
-
-                    // initialize the pixel format handler
-                    // if it fails, stop the video on worker thread and delete it
-                    if(!new_pixel_format_handler->init(error))
-                    {
-                        nap::Logger::error("%s: Unable to initialize pixel format handler", mID.c_str());
-
-                        enqueueWorkTask([this]()
-                        {
-                            mCurrentVideo = nullptr;
-                            mVideo = nullptr;
-                        });
-
-                        return;
-                    }
-
-                    // get the raw pointer of the new pixel format handler
-                    pixel_format_handler_ptr = new_pixel_format_handler.get();
-                }else
-                {
-                    // get the raw pointer of the current pixel format handler
-                    pixel_format_handler_ptr = mPixelFormatHandler.get();
-                }
-
-                // initialize the textures of the pixel format handler, this will delete and create new textures
-                // if the size of the video has changed
-                // if it fails, stop the video on worker thread and delete it
-                if(!pixel_format_handler_ptr->initTextures(size, error))
-                {
-                    nap::Logger::error("%s: Unable to initialize pixel format handler", mID.c_str());
-
-                    enqueueWorkTask([this]()
-                    {
-                        mCurrentVideo = nullptr;
-                        mVideo = nullptr;
-                    });
-
-                    return;
-                }
-
-                // if we created a new pixel format handler, move ownership and notify any listeners (like the render component)
-                // that the pixel format handler has changed
-                if(create_new_pixel_format_handler)
-                {
-                    mPixelFormatHandler = std::move(new_pixel_format_handler);
-                    onPixelFormatHandlerChanged(*mPixelFormatHandler);
-                }
-
-                // copy some properties to the main thread
                 mVideoSize = size;
-                mDuration = duration;
                 mHasAudio = has_audio;
                 mVideoLoaded = true;
 
@@ -275,7 +490,8 @@ namespace nap
                     double start_time = mStartTime;
                     enqueueWorkTask([this, start_time]()
                     {
-                        mCurrentVideo->play(start_time);
+                        mCurrentVideo->play(start_time + getEntryInPoint());
+                        flushFrames();
                     });
                 }
             });
@@ -286,21 +502,42 @@ namespace nap
     void ThreadedVideoPlayer::clearTextures()
     {
         if(hasPixelFormatHandler())
+        {
             mPixelFormatHandler->clearTextures();
+            mPixelFormatHandler->advanceFrameGeneration();
+        }
     }
 
 
     bool ThreadedVideoPlayer::start(utility::ErrorState& errorState)
     {
+        if(!errorState.check(mDecodeAheadFrames > 0, "%s: DecodeAheadFrames must be at least 1", mID.c_str()))
+            return false;
+
+        // Initial playback properties
+        mLoopTarget = mLoop;
+        mSpeedTarget = mSpeed;
+
         mImpl = std::make_unique<Impl>();
+        mImpl->mFrames.init(mDecodeAheadFrames);
+        mImpl->mConverter = std::make_unique<VideoFormatConverter>(mService.getWorkerPool(), mService.getFramePool());
 
-        if(!mFilePath.empty())
+        // Staging buffers for the frames decoded ahead, the frame that is presented and the frames the GPU is still copying
+        if(mStagedUpload)
         {
-            loadVideo(mFilePath);
+            auto* render_service = mService.getCore().getService<RenderService>();
+            assert(render_service != nullptr);
+            mImpl->mStaging = std::make_unique<VideoStagingRing>(*render_service);
+            mImpl->mStaging->init(mDecodeAheadFrames + render_service->getMaxFramesInFlight() + 2);
         }
 
+        // Allow work cycles to be scheduled on the worker pool of the service
         mRunning = true;
-        mThread = std::thread(&ThreadedVideoPlayer::onWork, this);
+
+        if(!mFilePath.empty())
+        {
+            loadVideo(mFilePath);
+        }
 
         // Register device
         mService.registerPlayer(*this);
@@ -325,10 +562,20 @@ namespace nap
         if(!mVideoLoaded)
             return;
 
-        enqueueWorkTask([this]()
+        // play positions the video itself, seeks issued before play don't apply
+        double start_time = mStartTime;
+        uint32 seek_sequence = mSeekSequence.load();
+        enqueueWorkTask([this, start_time, seek_sequence]()
         {
+            discardSeeks(seek_sequence);
             if(mCurrentVideo!= nullptr)
-                mCurrentVideo->play(mStartTime);
+            {
+                mCurrentVideo->play(start_time + getEntryInPoint());
+                mExactSeekTarget = -1.0;
+                mEntryStarted = false;
+                mEntryFinished = false;
+                flushFrames();
+            }
         });
     }
 
@@ -337,11 +584,10 @@ namespace nap
     {
         mLoop = value;
 
-        enqueueWorkTask([this, value]()
-        {
-            if(mCurrentVideo!= nullptr)
-                mCurrentVideo->mLoop = value;
-        });
+        // Latest wins, applied at the start of the next work cycle
+        mLoopTarget = value;
+        mLoopChanged = true;
+        scheduleWork();
     }
 
 
@@ -349,89 +595,639 @@ namespace nap
     {
         mSpeed = speed;
 
-        enqueueWorkTask([this, speed]()
-        {
-            if(mCurrentVideo!= nullptr)
-                mCurrentVideo->mSpeed = speed;
-        });
+        // Latest wins, applied at the start of the next work cycle
+        mSpeedTarget = speed;
+        mSpeedChanged = true;
+        scheduleWork();
     }
 
 
     void ThreadedVideoPlayer::stop()
     {
-        // Unregister player
+        // Unregister player, no new work cycles are scheduled by the service
         mService.removePlayer(*this);
+        mRunning = false;
 
-        // stop video playback on worker thread
-        enqueueWorkTask([this]()
+        // wait for the work cycle in flight to finish
+        while(mWorkScheduled)
+            std::this_thread::yield();
+
+        // Discard pending work and clear all videos
+        Task task;
+        while(mWorkThreadTasks.try_dequeue(task)) { }
+        mCurrentVideo = nullptr;
+
+        // Stop building the keyframe index
+        if(mImpl->mKeyframeIndex != nullptr)
         {
-            // Clear all videos
-            mCurrentVideo = nullptr;
-            mRunning = false;
+            mImpl->mKeyframeIndex->mCancelled = true;
+            mImpl->mKeyframeIndex = nullptr;
+        }
+
+        // Stop pre-rolling the next playlist entry
+        mImpl->cancelPreroll();
+        mPlaylist.clear();
+        mPlaylistIndex = -1;
+
+        // The staged frame that is not uploaded yet belongs to the staging ring of this player
+        if(hasPixelFormatHandler())
+            mPixelFormatHandler->discardStagedFrame();
+    }
+
+
+    void ThreadedVideoPlayer::scheduleWork()
+    {
+        // Only one work cycle can be in flight, this keeps the tasks and frames of this player in order
+        if(!mRunning || mWorkScheduled.exchange(true))
+            return;
+
+        mService.getWorkerPool().enqueue([this]() { runWork(); });
+    }
+
+
+    void ThreadedVideoPlayer::runWork()
+    {
+        // Player is stopping, release it
+        if(!mRunning)
+        {
+            mWorkScheduled = false;
+            return;
+        }
+
+        // Keep the work cycle scheduled while there is something to decode or tasks are pending,
+        // the player is only released when idle
+        double delay = onWork();
+        if(delay < 0.0 && mWorkThreadTasks.size_approx() == 0)
+        {
+            mWorkScheduled = false;
+            return;
+        }
+
+        auto& pool = mService.getWorkerPool();
+        if(delay <= 0.0)
+        {
+            pool.enqueue([this]() { runWork(); });
+            return;
+        }
+
+        auto due = SteadyClock::now() + std::chrono::duration_cast<SteadyClock::duration>(std::chrono::duration<double>(delay));
+        pool.enqueueAt(due, [this]() { runWork(); });
+    }
+
+
+    void ThreadedVideoPlayer::flushFrames()
+    {
+        // Frames of the previous epoch are discarded by the main thread, restart decoding at the presentation clock
+        mEpoch.fetch_add(1);
+        mDecodeClock = mPresentationClock.load();
+        mWorkerState.mLastPTS = -1.0;
+    }
+
+
+    void ThreadedVideoPlayer::discardSeeks(uint32 sequence)
+    {
+        // Sequences only move forward, never go back to an older one
+        if(static_cast<int32>(sequence - mAppliedSeekSequence) > 0)
+            mAppliedSeekSequence = sequence;
+    }
+
+
+    void ThreadedVideoPlayer::loadKeyframeIndex(const std::string& path)
+    {
+        // Stop building the index of the previous video
+        auto& current = mImpl->mKeyframeIndex;
+        if(current != nullptr)
+            current->mCancelled = true;
+        current = nullptr;
+
+        if(!mBuildKeyframeIndex)
+            return;
+
+        current = std::make_shared<Impl::KeyframeIndex>();
+        current->mPath = path;
+        current->mCachePath = VideoKeyframeIndex::getCachePath(path, mService.getKeyframeIndexDirectory());
+
+        auto& pool = mService.getWorkerPool();
+        auto index = current;
+        pool.enqueue([&pool, index]() { Impl::buildKeyframeIndex(pool, index); });
+    }
+
+
+    double ThreadedVideoPlayer::getEntryInPoint() const
+    {
+        return mPlaylistIndex >= 0 ? mPlaylist[mPlaylistIndex].mInPoint : 0.0;
+    }
+
+
+    double ThreadedVideoPlayer::getEntryOutPoint() const
+    {
+        if(mPlaylistIndex >= 0)
+            return mPlaylist[mPlaylistIndex].mOutPoint;
+        return mLoopTarget.load() ? mSegmentOutPoint : -1.0;
+    }
+
+
+    bool ThreadedVideoPlayer::hasNextEntry() const
+    {
+        return !mPlaylist.empty() || mLoopTarget.load();
+    }
+
+
+    bool ThreadedVideoPlayer::isInEntryTail() const
+    {
+        double out_point = getEntryOutPoint();
+        double end = out_point >= 0.0 ? out_point : mWorkerState.mDuration;
+        return mWorkerState.mLastPTS >= 0.0 && mWorkerState.mLastPTS >= end - sLoopPrerollLead;
+    }
+
+
+    void ThreadedVideoPlayer::getNextEntry(int& outIndex, std::string& outPath, double& outInPoint) const
+    {
+        // A looping video follows itself, starting at the in point of the loop segment.
+        // In a playlist the entry after the last one is the first one when looping.
+        outIndex = -1;
+        outPath.clear();
+        outInPoint = 0.0;
+        if(mPlaylist.empty())
+        {
+            if(mLoopTarget.load())
+            {
+                outPath = mVideoPath;
+                outInPoint = mSegmentInPoint;
+            }
+            return;
+        }
+
+        outIndex = mPlaylistIndex + 1;
+        if(outIndex >= static_cast<int>(mPlaylist.size()))
+            outIndex = mLoopTarget.load() ? 0 : -1;
+
+        if(outIndex >= 0)
+        {
+            outPath = mPlaylist[outIndex].mPath;
+            outInPoint = mPlaylist[outIndex].mInPoint;
+        }
+    }
+
+
+    void ThreadedVideoPlayer::prerollNextEntry()
+    {
+        int next_index = -1;
+        std::string next_path;
+        double next_in_point = 0.0;
+        getNextEntry(next_index, next_path, next_in_point);
+
+        // Already pre-rolling the next entry
+        auto& preroll = mImpl->mPreroll;
+        if(preroll != nullptr && preroll->mIndex == next_index && preroll->mPath == next_path && preroll->mInPoint == next_in_point)
+            return;
+
+        // Nothing follows, or the next entry plays the current file and the tail of the current entry isn't playing yet
+        mImpl->cancelPreroll();
+        if(next_path.empty() || (next_path == mVideoPath && !isInEntryTail()))
+            return;
+
+        preroll = std::make_shared<Impl::Preroll>();
+        preroll->mPath = next_path;
+        preroll->mInPoint = next_in_point;
+        preroll->mSpeed = mSpeedTarget.load();
+        preroll->mNumThreads = mNumThreads;
+        preroll->mIndex = next_index;
+
+        auto& pool = mService.getWorkerPool();
+        auto task_preroll = preroll;
+        pool.enqueue([&pool, task_preroll]() { Impl::prerollVideo(pool, task_preroll); });
+    }
+
+
+    bool ThreadedVideoPlayer::handoverToNextEntry()
+    {
+        // Nothing pre-rolled: rewind the current decoder when the next entry plays the same file, otherwise end of the playlist.
+        // The loop head of the same file is pre-rolled while the tail plays, this only seeks when the tail was skipped.
+        auto& preroll = mImpl->mPreroll;
+        if(preroll == nullptr)
+        {
+            int next_index = -1;
+            std::string next_path;
+            double next_in_point = 0.0;
+            getNextEntry(next_index, next_path, next_in_point);
+            if(!next_path.empty() && next_path == mVideoPath)
+                return rewindToEntry(next_index, next_in_point);
+
+            if(mCurrentVideo->isPlaying())
+                mCurrentVideo->stop(true);
+            return false;
+        }
+
+        // The next entry can't be played, end playlist or loop playback
+        if(preroll->mFailed)
+        {
+            nap::Logger::error("%s: Unable to continue playback with file: %s", mID.c_str(), preroll->mPath.c_str());
+            mImpl->cancelPreroll();
+            mPlaylist.clear();
+            mPlaylistIndex = -1;
+            if(mCurrentVideo->isPlaying())
+                mCurrentVideo->stop(true);
+            return false;
+        }
+
+        // First frame not decoded yet, or no room for it
+        auto& frames = mImpl->mFrames;
+        if(!preroll->mReady || frames.isFull())
+            return false;
+
+        // Take over the pre-rolled video, the previous video is released
+        Frame first_frame = preroll->mFirstFrame;
+        preroll->mFirstFrame.mFrame = nullptr;
+        mVideo = std::move(preroll->mVideo);
+        mCurrentVideo = mVideo.get();
+        mCurrentVideo->mSpeed = mSpeedTarget.load();
+        mPlaylistIndex = preroll->mIndex;
+        std::string path = preroll->mPath;
+        mImpl->mPreroll = nullptr;
+
+        mWorkerState.mDuration = mCurrentVideo->getDuration();
+        mWorkerState.mLastPTS = -1.0;
+        mEntryFinished = false;
+        mEntryStarted = true;
+        mExactSeekTarget = -1.0;
+
+        // A looping video keeps its keyframe index
+        if(path != mVideoPath)
+        {
+            mVideoPath = path;
+            VideoProbe probe;
+            mCacheProbe = !mService.getProbeCache().find(path, probe);
+            loadKeyframeIndex(path);
+        }
+
+        // The first frame is due one frame after the last frame of the previous entry, no frames are flushed
+        mLastFrameTime += mFrameDuration;
+        mDecodeClock = mLastFrameTime;
+        trackFrame(first_frame);
+        updateFrameIndex(first_frame);
+        pushFrame(first_frame, mLastFrameTime);
+
+        // copy some properties to the main thread
+        glm::vec2 size = { mCurrentVideo->getWidth(), mCurrentVideo->getHeight() };
+        bool has_audio = mCurrentVideo->hasAudio();
+        enqueueMainTask([this, size, has_audio]()
+        {
+            mVideoSize = size;
+            mHasAudio = has_audio;
         });
 
-        // wait for worker thread to finish
-        while(!mWorkDone)
+        prerollNextEntry();
+        return true;
+    }
+
+
+    bool ThreadedVideoPlayer::rewindToEntry(int index, double inPoint)
+    {
+        // No frames are flushed, the decode clock continues one frame after the last frame of the previous entry
+        if(mCurrentVideo->isPlaying())
+            mCurrentVideo->seek(inPoint);
+        else
+            mCurrentVideo->play(inPoint);
+
+        mPlaylistIndex = index;
+        mWorkerState.mLastPTS = -1.0;
+        mEntryFinished = false;
+        mEntryStarted = false;
+        mExactSeekTarget = -1.0;
+        mPresentNextFrame = false;
+        mDecodeClock = mLastFrameTime;
+
+        // Pre-roll the entry after this one, a same file entry once its tail plays
+        prerollNextEntry();
+        return true;
+    }
+
+
+    void ThreadedVideoPlayer::applyControlCommands()
+    {
+        if(mCurrentVideo == nullptr)
+            return;
+
+        if(mSpeedChanged.exchange(false))
+            mCurrentVideo->mSpeed = mSpeedTarget.load();
+
+        // Looping determines which entry follows the current one, a playlist loops as a whole
+        if(mLoopChanged.exchange(false))
+            prerollNextEntry();
+
+        // Only the most recent seek target is executed, intermediate targets are dropped
+        uint32 seek_sequence = mSeekSequence.load();
+        if(seek_sequence != mAppliedSeekSequence)
         {
-            mUpdateWorker = true;
-            mWorkSignal.notify_one();
+            mAppliedSeekSequence = seek_sequence;
+            int64 seek_frame = mSeekFrame.load();
+            if(seek_frame < 0)
+            {
+                mCurrentVideo->seek(mSeekTarget.load());
+                mExactSeekTarget = -1.0;
+                mPresentNextFrame = mScrubbing.load();
+            }
+            else
+            {
+                // Seek to the preceding keyframe and decode forward to the frame, the frame is presented as soon as it's decoded.
+                // Without an index the frame time is estimated and the demuxer picks the keyframe.
+                const auto* index = mImpl->mKeyframeIndex != nullptr && mImpl->mKeyframeIndex->mReady ? &mImpl->mKeyframeIndex->mIndex : nullptr;
+                if(index != nullptr && index->getFrameRate() > 0.0)
+                {
+                    mExactSeekTarget = index->frameToSeconds(seek_frame);
+                    mCurrentVideo->seek(index->findKeyframe(mExactSeekTarget));
+                }
+                else
+                {
+                    mExactSeekTarget = static_cast<double>(seek_frame) * mFrameInterval;
+                    mCurrentVideo->seek(mExactSeekTarget);
+                }
+                mPresentNextFrame = true;
+            }
+
+            flushFrames();
+            mMeasureSeek = true;
+            mSeekTimeStamp = SteadyClock::now();
+            mEntryFinished = false;
         }
+    }
+
 
-        // join worker thread
-        if(mThread.joinable())
-            mThread.join();
+    bool ThreadedVideoPlayer::decodeToSeekTarget(double presentationTime)
+    {
+        for(int i = 0; i < sExactSeekFramesPerCycle && mCurrentVideo->isPlaying(); i++)
+        {
+            // The decoder has no frame available yet, try again later
+            Frame frame = mCurrentVideo->update(mFrameDuration);
+            if(!frame.isValid())
+            {
+                frame.free();
+                return false;
+            }
+
+            // Track the frame interval, the first seek can be issued before the index is ready
+            trackFrame(frame);
+
+            // Discard frames before the target, allow for time stamp rounding
+            if(frame.mPTSSecs < mExactSeekTarget - mFrameInterval * 0.5)
+            {
+                frame.free();
+                continue;
+            }
+
+            // Landed, the decode clock restarts at this frame
+            mExactSeekTarget = -1.0;
+            updateFrameIndex(frame);
+            mPresentNextFrame = false;
+            mDecodeClock = presentationTime;
+            mLastFrameTime = presentationTime;
+            mEntryStarted = true;
+            pushFrame(frame, presentationTime);
+            return true;
+        }
+        return true;
+    }
+
+
+    void ThreadedVideoPlayer::publishState()
+    {
+        mWorkerState.mPlaying = mCurrentVideo != nullptr && mCurrentVideo->isPlaying();
+        mWorkerState.mKeyframeIndexReady = mImpl->mKeyframeIndex != nullptr && mImpl->mKeyframeIndex->mReady;
+        mWorkerState.mPlaylistIndex = mPlaylistIndex;
+        if(mCurrentVideo != nullptr)
+            mWorkerState.mCurrentTime = mCurrentVideo->getCurrentTime();
+        mPlaybackState.store(mWorkerState);
+    }
+
+
+    void ThreadedVideoPlayer::updateFrameIndex(const Frame& frame)
+    {
+        // Derived from the presentation time, with the same frame rate seekToFrame() uses:
+        // stays valid across seeks, loops and playlist entries
+        const auto* index = mImpl->mKeyframeIndex != nullptr && mImpl->mKeyframeIndex->mReady ? &mImpl->mKeyframeIndex->mIndex : nullptr;
+        double frame_rate = index != nullptr && index->getFrameRate() > 0.0 ? index->getFrameRate() : 1.0 / mFrameInterval;
+        mWorkerState.mFrameIndex = frame.mPTSSecs >= 0.0 ? std::llround(frame.mPTSSecs * frame_rate) : -1;
     }
 
 
-    void ThreadedVideoPlayer::onWork()
+    void ThreadedVideoPlayer::trackFrame(const Frame& frame)
     {
-        mWorkDone = false;
-        SteadyTimeStamp time_stamp = SteadyClock::now();
-        while(mRunning)
+        // Estimate the frame interval and the frame duration at the current playback speed
+        double pts_delta = frame.mPTSSecs - mWorkerState.mLastPTS;
+        if(mWorkerState.mLastPTS >= 0.0 && pts_delta > 0.0 && pts_delta < 1.0)
         {
-            // Update worker
-            mUpdateWorker = false;
+            mFrameInterval = pts_delta;
+            mFrameDuration = pts_delta / std::max(static_cast<double>(std::abs(mCurrentVideo->mSpeed)), 0.01);
 
-            // Execute queued tasks
-            if(mWorkThreadTasks.size_approx() > 0)
+            // Pixel format, size and frame rate are known now, cache them for the next load of this file
+            if(mCacheProbe)
             {
-                Task task;
-                while(mWorkThreadTasks.try_dequeue(task))
-                    task();
+                storeProbe(mVideoPath, *mCurrentVideo, frame, pts_delta);
+                mCacheProbe = false;
             }
+        }
+        mWorkerState.mLastPTS = frame.mPTSSecs;
+    }
 
-            // Calculate frame duration seconds
-            SteadyTimeStamp current_time = SteadyClock::now();
-            double delta_time = std::chrono::duration<double>(current_time - time_stamp).count();
-            time_stamp = current_time;
 
-            // Update video
-            if(mCurrentVideo!= nullptr)
+    void ThreadedVideoPlayer::pushFrame(const Frame& frame, double presentationTime)
+    {
+        // Frames of a pixel format no handler supports are converted to one that is, on this worker and the pool
+        Frame decoded_frame = frame;
+        if(decoded_frame.mFrame->format != mImpl->mDecodedFormat)
+        {
+            mImpl->mDecodedFormat = decoded_frame.mFrame->format;
+            mImpl->mUploadFormat = utility::getVideoConversionFormat(mImpl->mDecodedFormat);
+            bool convert = mImpl->mUploadFormat >= 0 && mImpl->mUploadFormat != mImpl->mDecodedFormat;
+            mImpl->mTransformFormat = utility::getVideoTransformFormat(convert ? mImpl->mUploadFormat : mImpl->mDecodedFormat, mReduceBitDepth, mInterleaveChroma);
+            mWorkerState.mConvertedPixelFormat = convert ? mImpl->mDecodedFormat : -1;
+            mWorkerState.mConversionTime = 0.0;
+            if(convert)
             {
-                // Update video and get frame
-                // if frame is valid, enqueue it to the main thread for processing
-                Frame frame = mCurrentVideo->update(delta_time);
-                if(frame.isValid())
-                    mImpl->mFrames.enqueue(frame);
-                else
-                    frame.free();
+                const char* decoded_name = av_get_pix_fmt_name(static_cast<AVPixelFormat>(mImpl->mDecodedFormat));
+                const char* upload_name = av_get_pix_fmt_name(static_cast<AVPixelFormat>(mImpl->mUploadFormat));
+                nap::Logger::warn("%s: pixel format %s of %s is not supported, converting to %s on the worker, re-encode the video for better performance",
+                    mID.c_str(), decoded_name != nullptr ? decoded_name : "unknown", mVideoPath.c_str(), upload_name != nullptr ? upload_name : "unknown");
+            }
+        }
 
-                // Update current time and playing state on main thread
-                double current_time_video = mCurrentVideo->getCurrentTime();
-                bool is_playing = mCurrentVideo->isPlaying();
-                enqueueMainTask([this, current_time_video, is_playing]()
+        if(mWorkerState.mConvertedPixelFormat >= 0)
+        {
+            Frame converted_frame;
+            if(mImpl->mConverter->convert(decoded_frame, converted_frame))
+            {
+                mService.getFramePool().release(decoded_frame);
+                decoded_frame = converted_frame;
+                mWorkerState.mConversionTime = mImpl->mConverter->getConversionTime();
+            }
+        }
+
+        // Copy the planes to upload memory while the frame is hot in the cache of this worker,
+        // the staged frame replaces the decoded frame and its buffers return to the decoder right away.
+        // Planes are expanded, swapped or reduced to the transform format on the way, see utility::getVideoTransformFormat().
+        Frame staged_frame;
+        int transform_format = mImpl->mTransformFormat >= 0 ? mImpl->mTransformFormat : decoded_frame.mFrame->format;
+        int staging_slot = mImpl->mStaging != nullptr ? mImpl->mStaging->fill(decoded_frame, transform_format, staged_frame) : -1;
+        if(staging_slot < 0)
+        {
+            // No free staging buffer, transform into a pooled frame so the handler doesn't change format
+            if(transform_format != decoded_frame.mFrame->format)
+            {
+                Frame transformed_frame = mService.getFramePool().acquire(transform_format, decoded_frame.mFrame->width, decoded_frame.mFrame->height);
+                if(transformed_frame.isValid() && utility::transformVideoFrame(*decoded_frame.mFrame, transform_format, transformed_frame.mFrame->data, transformed_frame.mFrame->linesize))
                 {
-                    mCurrentTime = current_time_video;
-                    mPlaying = is_playing;
-                });
+                    transformed_frame.mPTSSecs = decoded_frame.mPTSSecs;
+                    mService.getFramePool().release(decoded_frame);
+                    decoded_frame = transformed_frame;
+                }
+                else if(transformed_frame.isValid())
+                {
+                    mService.getFramePool().release(transformed_frame);
+                }
+            }
+            mImpl->mFrames.push({ decoded_frame, presentationTime, mEpoch.load(), -1 });
+            return;
+        }
+
+        mService.getFramePool().release(decoded_frame);
+        mImpl->mFrames.push({ staged_frame, presentationTime, mEpoch.load(), staging_slot });
+    }
+
+
+    void ThreadedVideoPlayer::releaseFrame(Frame& frame, int stagingSlot)
+    {
+        // A staged frame lives in its staging slot
+        if(stagingSlot >= 0)
+        {
+            mImpl->mStaging->release(stagingSlot);
+            frame = Frame();
+            return;
+        }
+        mService.getFramePool().release(frame);
+    }
+
+
+    double ThreadedVideoPlayer::onWork()
+    {
+        // Execute queued tasks
+        if(mWorkThreadTasks.size_approx() > 0)
+        {
+            Task task;
+            while(mWorkThreadTasks.try_dequeue(task))
+                task();
+        }
+
+        // Apply latest seek, speed and loop commands
+        applyControlCommands();
+
+        // Nothing to decode
+        if(mCurrentVideo == nullptr)
+        {
+            publishState();
+            return -1.0;
+        }
+
+        // Decode ahead of the presentation clock, until the ring is full or we're far enough ahead.
+        // When the decode clock fell behind, skip ahead: frames that are already late are never shown.
+        auto& frames = mImpl->mFrames;
+        double presentation_time = mPresentationClock.load();
+        mDecodeClock = std::max(mDecodeClock, presentation_time);
+        double target_time = presentation_time + frames.getCapacity() * mFrameDuration;
+        bool decoder_ready = true;
+        bool seek_cancelled = false;
+        bool frame_decoded = false;
+
+        // Frame exact seek: decode to the target first, a newer seek cancels it
+        if(mExactSeekTarget >= 0.0 && !frames.isFull())
+        {
+            decoder_ready = decodeToSeekTarget(presentation_time);
+            seek_cancelled = mSeekSequence.load() != mAppliedSeekSequence;
+            frame_decoded = mExactSeekTarget < 0.0;
+        }
+
+        double out_point = getEntryOutPoint();
+        while(mExactSeekTarget < 0.0 && !seek_cancelled && !mEntryFinished && mCurrentVideo->isPlaying() && mDecodeClock < target_time && !frames.isFull())
+        {
+            // In scrub mode a newer seek target cancels the work for the current one
+            if(mScrubbing && mSeekSequence.load() != mAppliedSeekSequence)
+            {
+                seek_cancelled = true;
+                break;
+            }
+
+            // Advance at most one frame at a time, this ensures no decoded frame is skipped
+            double step = std::min(target_time - mDecodeClock, mFrameDuration);
+            Frame frame = mCurrentVideo->update(step);
+            mDecodeClock += step;
+
+            // The decoder has no frame available yet, try again later
+            if(!frame.isValid())
+            {
+                frame.free();
+                decoder_ready = false;
+                break;
             }
 
-            // wait for update signal coming from the main thread
-            std::unique_lock<std::mutex> lock(mMutex);
-            mWorkSignal.wait(lock, [this] { return mUpdateWorker.load() || !mRunning.load(); });
+            // The entry reached its out point, the next entry or the loop head takes over
+            if(out_point >= 0.0 && frame.mPTSSecs >= out_point)
+            {
+                frame.free();
+                mEntryFinished = true;
+                break;
+            }
+
+            // Estimate the frame duration from the decoded presentation time stamps
+            trackFrame(frame);
+            updateFrameIndex(frame);
+
+            // The first frame after a scrub seek is due immediately
+            double frame_time = mPresentNextFrame ? presentation_time : mDecodeClock;
+            mPresentNextFrame = false;
+            mLastFrameTime = frame_time;
+            mEntryStarted = true;
+            pushFrame(frame, frame_time);
+            frame_decoded = true;
+        }
+
+        // Pre-roll the loop head of the same file once the tail of the entry plays
+        if(frame_decoded && mImpl->mPreroll == nullptr && hasNextEntry() && isInEntryTail())
+            prerollNextEntry();
+
+        // The entry finished, hand over to the next entry or the loop head on the frame boundary
+        bool handed_over = false;
+        if(hasNextEntry())
+        {
+            mEntryFinished = mEntryFinished || (mEntryStarted && !mCurrentVideo->isPlaying());
+            handed_over = mEntryFinished && handoverToNextEntry();
+        }
+
+        // Measure the time it took to land the last seek
+        if(mMeasureSeek && frame_decoded)
+        {
+            mMeasureSeek = false;
+            mWorkerState.mSeekLatency = std::chrono::duration<double>(SteadyClock::now() - mSeekTimeStamp).count();
+            nap::Logger::debug("%s: seek landed in %.2f ms", mID.c_str(), mWorkerState.mSeekLatency * 1000.0);
         }
 
-        mWorkDone = true;
+        // Publish the playback state, steady state playback does not allocate
+        publishState();
+
+        // Waiting for the pre-roll of the next entry
+        if(mEntryFinished && mImpl->mPreroll != nullptr)
+            return sDecoderPollInterval;
+
+        // Video stopped, nothing left to decode
+        if(!mWorkerState.mPlaying)
+            return -1.0;
+
+        // Pick up the newer seek target right away, continue decoding to the target of a frame exact seek
+        // or continue decoding the entry that took over
+        if(seek_cancelled || handed_over || (mExactSeekTarget >= 0.0 && decoder_ready && !frames.isFull()))
+            return 0.0;
+
+        // Poll the decoder when it had no frame available, otherwise wait for the presentation clock to catch up
+        return decoder_ready ? mFrameDuration * 0.5 : sDecoderPollInterval;
     }
 
 
@@ -445,21 +1241,78 @@ namespace nap
                 task();
         }
 
-        // Process new frames
-        Frame frame;
-        while(mImpl->mFrames.try_dequeue(frame))
+        // Advance the presentation clock
+        double presentation_time = mPresentationClock.load();
+        if(mPlaying && mPlaybackState.load().mPlaying)
         {
-            // only process last valid frame
-            // this is to avoid processing frames that are not in sync with the main thread
-            if(frame.isValid() && mImpl->mFrames.size_approx() == 0)
-                mPixelFormatHandler->update(frame);
+            presentation_time += deltaTime;
+            mPresentationClock.store(presentation_time);
+        }
+
+        // Reclaim the staging buffers the GPU is done with
+        auto* staging = mImpl->mStaging.get();
+        if(staging != nullptr)
+            staging->update();
+
+        // Pop all frames that are due, discard frames of a previous epoch
+        // only process the last due frame, the others are too late to be shown
+        auto& frames = mImpl->mFrames;
+        uint32 epoch = mEpoch.load();
+        Frame present_frame;
+        int present_slot = -1;
+        VideoFrameRing::Entry entry;
+        while(const auto* next = frames.peek())
+        {
+            bool stale = next->mEpoch < epoch;
+            if(!stale && next->mPresentationTime > presentation_time)
+                break;
+
+            frames.pop(entry);
+            if(stale)
+            {
+                releaseFrame(entry.mFrame, entry.mStagingSlot);
+                continue;
+            }
+
+            releaseFrame(present_frame, present_slot);
+            present_frame = entry.mFrame;
+            present_slot = entry.mStagingSlot;
+        }
 
-            frame.free();
+        // The pixel format handler is created or updated when the pixel format or size changes
+        if(present_frame.isValid() && mVideoLoaded)
+        {
+            utility::ErrorState error;
+            double pts = present_frame.mPTSSecs;
+            bool presented = staging != nullptr ? presentFrame(present_frame, *staging, present_slot, error) : presentFrame(present_frame, error);
+
+            // The staging slot, and the staged frame that lives in it, is taken by the handler or released
+            if(present_slot >= 0)
+            {
+                present_frame = Frame();
+                present_slot = -1;
+            }
+
+            if(presented)
+            {
+                mCurrentTime = pts;
+            }
+            else
+            {
+                // stop the video on worker thread and delete it
+                nap::Logger::error("%s: %s", mID.c_str(), error.toString().c_str());
+                mVideoLoaded = false;
+                enqueueWorkTask([this]()
+                {
+                    mCurrentVideo = nullptr;
+                    mVideo = nullptr;
+                    flushFrames();
+                });
+            }
         }
+        releaseFrame(present_frame, present_slot);
 
-        // keep worker thread in lockstep with main thread
-        // signal worker thread to update
-        mUpdateWorker = true;
-        mWorkSignal.notify_one();
+        // Make sure queued work gets picked up, this is a no-op when a work cycle is already in flight
+        scheduleWork();
     }
 }
@@ -5,16 +5,18 @@
 #pragma once
 
 // Local Includes
-#include "videofile.h"
 #include "video.h"
 #include "videoplayeradvanced.h"
 #include "videopixelformathandler.h"
+#include "videoframering.h"
+#include "videoplaybackstate.h"
 #include "concurrentqueue.h"
 
 // External Includes
 #include <nap/device.h>
 #include <nap/resourceptr.h>
 #include <nap/numeric.h>
+#include <nap/datetime.h>
 #include <texture.h>
 
 namespace nap
@@ -22,6 +24,17 @@ namespace nap
     // Forward Declares
     class VideoAdvancedService;
 
+    /**
+     * Entry of a threaded video player playlist, an edit decision list entry when in and out points are set.
+     */
+    struct NAPAPI VideoPlaylistEntry
+    {
+        std::string mPath;                  ///< Path to the video file
+        double mInPoint = 0.0;              ///< Time in seconds in the video to start playback at
+        double mOutPoint = -1.0;            ///< Time in seconds in the video to hand over to the next entry, negative to play until the end
+    };
+
+
     class NAPAPI ThreadedVideoPlayer final : public VideoPlayerAdvancedBase
     {
     RTTI_ENABLE(VideoPlayerAdvancedBase)
@@ -47,16 +60,32 @@ namespace nap
 
         /**
          * Check if the currently loaded video is playing.
+         * Returns the requested state, set by play() and stopPlayback(). Use getPlaybackState() for the state of the decoder.
          * @return If the video is currently playing.
          */
         bool isPlaying() const;
 
         /**
          * If the video re-starts after completion.
+         * The start of the video, or of the loop segment, is pre-rolled on a second decoder while the tail plays,
+         * the wrap does not seek and is gapless. The second decoder is only open during the last seconds before the wrap.
          * @param value if the video re-starts after completion.
          */
         void loop(bool value);
 
+        /**
+         * Sets the segment of the current video that loops when looping is enabled, reset when a new video is loaded.
+         * The in point is pre-rolled while the tail of the segment plays, the wrap at the out point is gapless.
+         * @param inPoint time in seconds the segment starts at
+         * @param outPoint time in seconds the segment ends at, negative to loop until the end of the video
+         */
+        void setLoopSegment(double inPoint, double outPoint);
+
+        /**
+         * Loops the whole video again.
+         */
+        void clearLoopSegment();
+
         /**
          * @return if the current video is looping
          */
@@ -75,10 +104,33 @@ namespace nap
 
         /**
          * Seeks within the video to the time provided. This can be called while playing.
+         * Seeks are coalesced: when multiple seeks are issued before the worker picks them up, only the last one is executed.
          * @param seconds: the time offset in seconds in the video.
          */
         void seek(double seconds);
 
+        /**
+         * Seeks to an exact frame within the video. This can be called while playing.
+         * The worker seeks to the keyframe that precedes the frame and decodes forward, discarding all frames before it.
+         * Uses the keyframe index when available, otherwise the frame time is estimated and the demuxer picks the keyframe.
+         * Coalesced with seek(), only the most recent seek is executed.
+         * @param frame the frame number to seek to, starting at 0
+         */
+        void seekToFrame(int64 frame);
+
+        /**
+         * Enables or disables scrub mode, enable it while the user is dragging a timeline.
+         * In scrub mode a newer seek target cancels the decode work of the seek in flight
+         * and the first frame after a seek is presented as soon as it is decoded.
+         * @param value if scrub mode is enabled
+         */
+        void setScrubbing(bool value);
+
+        /**
+         * @return if scrub mode is enabled
+         */
+        bool isScrubbing() const;
+
         /**
          * @return The current playback position in seconds.
          */
@@ -89,6 +141,13 @@ namespace nap
          */
         double getDuration() const;
 
+        /**
+         * Returns the playback state as last published by the decode worker.
+         * Wait-free for the worker, lock-free for the caller, safe to call from any thread.
+         * @return the playback state of the decoder
+         */
+        VideoPlaybackState getPlaybackState() const;
+
         /**
          * @return Width of the video, in pixels.
          */
@@ -117,14 +176,34 @@ namespace nap
         virtual void stop() override;
 
         /**
-         * Load a video from a file path.
+         * Load a video from a file path, ends playlist playback.
          * @param filePath The path to the video file.
          */
         void loadVideo(const std::string& filePath);
 
+        /**
+         * Plays the given entries back to back, without gaps. Loads the first entry, start playback with play(),
+         * the start time is relative to the in point of the first entry. The playlist wraps around when looping is enabled.
+         * While an entry plays, the next one is opened, probed and decoded to its first frame in the background,
+         * it takes over on the frame boundary after the last frame of the current entry.
+         * The pixel format handler and textures are shared when the pixel format and size of both entries match.
+         * @param entries the playlist entries
+         */
+        void setPlaylist(const std::vector<VideoPlaylistEntry>& entries);
+
+        /**
+         * Ends playlist playback, the current entry continues to play as a regular video.
+         */
+        void clearPlaylist();
+
         std::string mFilePath;									///< Property: 'FilePath' Path to the video file, leave empty to not load a video on init
         bool mLoop = false;										///< Property: 'Loop' if the selected video loops
         float mSpeed = 1.0f;									///< Property: 'Speed' video playback speed
+        int mDecodeAheadFrames = 4;								///< Property: 'DecodeAheadFrames' number of frames the worker decodes ahead of presentation
+        bool mBuildKeyframeIndex = true;						///< Property: 'BuildKeyframeIndex' build or load a keyframe index in the background when a video is loaded
+        bool mStagedUpload = true;								///< Property: 'StagedUpload' copy frames to staging buffers on the worker, the main thread only records the texture copies
+        bool mReduceBitDepth = true;							///< Property: 'ReduceBitDepth' dither samples of more than 8 bits to 8 bits on the worker, the render output is 8 bits per channel
+        bool mInterleaveChroma = false;							///< Property: 'InterleaveChroma' interleave planar 4:2:0 chroma on the worker, uploads two textures per frame instead of three
     protected:
         /**
          * Update textures, can only be called by the video service
@@ -138,42 +217,205 @@ namespace nap
         void clearTextures();
 
         /**
-         * Enqueues a task to the work thread
+         * Enqueues a task to the main thread
          * @param task the task to enqueue
          */
         void enqueueMainTask(const Task& task){ mMainThreadTasks.enqueue(task); }
 
         /**
-         * Enqueues a task to the main thread
+         * Enqueues a task to the work thread
          * @param task the task to enqueue
          */
-        void enqueueWorkTask(const Task& task){ mWorkThreadTasks.enqueue(task); }
+        void enqueueWorkTask(const Task& task){ mWorkThreadTasks.enqueue(task); scheduleWork(); }
+
+        /**
+         * Executes a single work cycle: runs queued work tasks and decodes ahead until the frame ring is full
+         * or the decode clock is far enough ahead of the presentation clock.
+         * @return delay in seconds until the next work cycle, negative when there is nothing left to decode
+         */
+        double onWork();
+
+        /**
+         * Runs a work cycle on the worker pool and schedules the next one, or releases the player when idle.
+         */
+        void runWork();
+
+        /**
+         * Schedules a work cycle on the worker pool of the service, unless one is already in flight.
+         */
+        void scheduleWork();
+
+        /**
+         * Invalidates all decoded frames that are not presented yet, called on the worker thread after a seek or load.
+         */
+        void flushFrames();
+
+        /**
+         * Publishes the playback state of the current video, called on the worker thread at the end of every work cycle.
+         */
+        void publishState();
+
+        /**
+         * Applies the latest seek, speed and loop commands to the current video, called on the worker thread.
+         */
+        void applyControlCommands();
+
+        /**
+         * Marks all seeks issued up to the given sequence as handled, called on the worker thread.
+         * Used by play and load, which position the video themselves.
+         * @param sequence seek sequence at the time play or load was issued
+         */
+        void discardSeeks(uint32 sequence);
+
+        /**
+         * Starts building or loading the keyframe index of the given file in the background, called on the worker thread.
+         * Cancels the index of the previous video.
+         * @param path path to the video file
+         */
+        void loadKeyframeIndex(const std::string& path);
+
+        /**
+         * Decodes forward from the keyframe to the target of a frame exact seek, discarding all frames before the target.
+         * Called on the worker thread, does a bounded amount of work per cycle.
+         * @param presentationTime presentation clock at the start of the cycle
+         * @return if the decoder had frames available, false when it needs to be polled again later
+         */
+        bool decodeToSeekTarget(double presentationTime);
+
+        /**
+         * Updates the frame timing estimates with a decoded frame and caches the probe result of a new file,
+         * called on the worker thread for every decoded frame.
+         * @param frame the decoded frame
+         */
+        void trackFrame(const Frame& frame);
+
+        /**
+         * Sets the published frame index to the position of a frame that is pushed for presentation, worker thread only.
+         * @param frame the pushed frame
+         */
+        void updateFrameIndex(const Frame& frame);
+
+        /**
+         * Copies a decoded frame to the staging ring and queues it for presentation, called on the worker thread.
+         * @param frame the decoded frame, owned by the frame ring afterwards
+         * @param presentationTime point in time on the presentation clock the frame is shown
+         */
+        void pushFrame(const Frame& frame, double presentationTime);
+
+        /**
+         * Releases a frame that is not presented and its staging buffer, called on the main thread.
+         * @param frame the frame to release, invalid afterwards
+         * @param stagingSlot staging ring slot of the frame, -1 when not staged
+         */
+        void releaseFrame(Frame& frame, int stagingSlot);
+
+        /**
+         * Loads a video on the worker, does not change the playlist
+         * @param path the path to the video file
+         */
+        void load(const std::string& path);
+
+        /**
+         * Returns the playlist entry after the current one, or the loop head of a looping video, worker only.
+         * @param outIndex playlist index of the next entry, -1 for the loop head
+         * @param outPath path of the video file of the next entry, empty when nothing follows
+         * @param outInPoint time in seconds the next entry starts at
+         */
+        void getNextEntry(int& outIndex, std::string& outPath, double& outInPoint) const;
+
+        /**
+         * Starts pre-rolling the playlist entry after the current one, called on the worker thread.
+         * Cancels the pre-roll in flight when the next entry changed.
+         * When the next entry plays the current file it's only pre-rolled once the tail of the current entry plays.
+         */
+        void prerollNextEntry();
+
+        /**
+         * @return if the last decoded frame is within the last seconds of the current entry, worker only
+         */
+        bool isInEntryTail() const;
+
+        /**
+         * Hands over to the pre-rolled playlist entry when the current entry is finished, called on the worker thread.
+         * Rewinds the current decoder when nothing was pre-rolled and the next entry plays the same file.
+         * @return if the next entry took over
+         */
+        bool handoverToNextEntry();
+
+        /**
+         * Starts the next entry on the current decoder by seeking, the next entry plays the current file.
+         * Fallback for a wrap without pre-roll, called on the worker thread.
+         * @param index playlist index of the entry, -1 for the loop head
+         * @param inPoint time in seconds to start playback at
+         * @return if the entry took over
+         */
+        bool rewindToEntry(int index, double inPoint);
+
+        /**
+         * @return in point of the current playlist entry, 0 when not playing a playlist, worker only
+         */
+        double getEntryInPoint() const;
+
+        /**
+         * @return out point of the current playlist entry or loop segment, negative when there is none, worker only
+         */
+        double getEntryOutPoint() const;
+
+        /**
+         * @return if another entry or the loop head follows the current entry, worker only
+         */
+        bool hasNextEntry() const;
 
         bool mVideoLoaded = false;								///< If a video is currently loaded
 
-        std::atomic_bool mRunning = false;							///< If the video is currently playing
-        std::thread mThread;										///< Thread for video playback
-        void onWork();
+        std::atomic_bool mRunning = false;						///< If work cycles are allowed to be scheduled
+        std::atomic_bool mWorkScheduled = false;				///< If a work cycle is queued or running on the worker pool
+        std::atomic<double> mPresentationClock = { 0.0 };		///< Presentation clock in seconds, advanced by the main thread while playing
+        std::atomic<uint32> mEpoch = { 0 };						///< Frames decoded in an older epoch are discarded, bumped by the worker
+        double mDecodeClock = 0.0;								///< Decode clock in seconds, runs ahead of the presentation clock, worker only
+        double mFrameDuration = 1.0 / 60.0;						///< Estimated frame duration in seconds at the current speed, worker only
+        VideoPlaybackState mWorkerState;						///< Playback state of the decoder, worker only
+        std::string mVideoPath;									///< Path of the current video, worker only
+        bool mCacheProbe = false;								///< If the probe result of the current video still needs to be cached, worker only
+        std::vector<VideoPlaylistEntry> mPlaylist;				///< Playlist entries, empty when not playing a playlist, worker only
+        int mPlaylistIndex = -1;								///< Index of the current playlist entry, worker only
+        bool mEntryStarted = false;								///< If a frame of the current playlist entry was decoded, worker only
+        bool mEntryFinished = false;							///< If the current playlist entry reached its out point or end, worker only
+        double mLastFrameTime = 0.0;							///< Presentation time of the last decoded frame, worker only
+        double mSegmentInPoint = 0.0;							///< In point of the loop segment in seconds, worker only
+        double mSegmentOutPoint = -1.0;							///< Out point of the loop segment in seconds, negative for the end of the video, worker only
+
+        // Latest-wins control commands, written by the main thread and applied by the worker at the start of a cycle
+        std::atomic<double> mSeekTarget = { 0.0 };				///< Most recent seek target in seconds
+        std::atomic<int64> mSeekFrame = { -1 };					///< Most recent seek target in frames, -1 when seeking in seconds
+        std::atomic<uint32> mSeekSequence = { 0 };				///< Incremented for every seek
+        uint32 mAppliedSeekSequence = 0;						///< Sequence of the last applied seek, worker only
+        bool mPresentNextFrame = false;							///< Present the next decoded frame immediately, worker only
+        double mExactSeekTarget = -1.0;							///< Frames before this time in seconds are discarded, negative when not seeking, worker only
+        double mFrameInterval = 1.0 / 60.0;						///< Estimated time between frame time stamps in seconds, worker only
+        bool mMeasureSeek = false;								///< If the latency of the current seek is measured, worker only
+        SteadyTimeStamp mSeekTimeStamp;							///< Time the current seek was applied, worker only
+        std::atomic<float> mSpeedTarget = { 1.0f };				///< Most recent playback speed
+        std::atomic_bool mSpeedChanged = { false };				///< If the playback speed needs to be applied
+        std::atomic_bool mLoopTarget = { false };				///< Most recent loop state
+        std::atomic_bool mLoopChanged = { false };				///< If the loop state needs to be applied
+        std::atomic_bool mScrubbing = { false };				///< If scrub mode is enabled
+        VideoPlaybackStateSnapshot mPlaybackState;				///< Last published playback state, written by the worker
 
         moodycamel::ConcurrentQueue<Task> mWorkThreadTasks;	///< Work queue for the thread
         moodycamel::ConcurrentQueue<Task> mMainThreadTasks;	///< Work queue for the main thread
 
-        // Implementation, contains the frame queue
+        // Implementation, contains the decode-ahead frame ring
         struct Impl;
         std::unique_ptr<Impl> mImpl;
 
         nap::Video* mCurrentVideo = nullptr;					///< Current selected video context
         std::unique_ptr<nap::Video> mVideo;		                ///< The actual video
         double mCurrentTime = 0.0;								///< Current playback time in seconds
-        double mDuration = 0.0;									///< Duration of the video in seconds
         glm::vec2 mVideoSize = glm::vec2(0.0f);					///< Size of the video in pixels
-        bool mPlaying = false;									///< If the video is currently playing
+        bool mPlaying = false;									///< If playback is requested, see getPlaybackState() for the state of the decoder
         double mStartTime = 0.0;					            ///< Start time of the video in seconds
         bool mHasAudio = false;									///< If the video has an audio stream
-        std::atomic_bool mWorkDone = false;						///< If the worker thread is done
-        std::mutex mMutex;										///< Mutex for the update work signal
-        std::condition_variable mWorkSignal;					///< Signal for the update work
-        std::atomic_bool mUpdateWorker = false;					///< If the video needs to be updated
     };
 
     // Object creator
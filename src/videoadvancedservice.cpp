@@ -9,17 +9,59 @@
 #include <nap/core.h>
 #include <nap/resourcemanager.h>
 #include <nap/logger.h>
+#include <utility/fileutils.h>
 #include <iostream>
 
+RTTI_BEGIN_CLASS(nap::VideoAdvancedServiceConfiguration)
+	RTTI_PROPERTY("NumWorkerThreads",	&nap::VideoAdvancedServiceConfiguration::mNumWorkerThreads,	nap::rtti::EPropertyMetaData::Default, "Number of threads that decode all threaded video players, 0 means hardware threads minus one")
+	RTTI_PROPERTY("FramePoolSize",		&nap::VideoAdvancedServiceConfiguration::mFramePoolSize,		nap::rtti::EPropertyMetaData::Default, "Max number of idle frames kept per pixel format and size")
+	RTTI_PROPERTY("FramePoolHugePages",	&nap::VideoAdvancedServiceConfiguration::mFramePoolHugePages,	nap::rtti::EPropertyMetaData::Default, "Back large pooled frames with huge pages, where supported")
+	RTTI_PROPERTY("KeyframeIndexDirectory",	&nap::VideoAdvancedServiceConfiguration::mKeyframeIndexDirectory,	nap::rtti::EPropertyMetaData::Default, "Directory that holds keyframe index cache files, when empty the cache is stored next to the video file")
+	RTTI_PROPERTY("ProbeCacheFile",		&nap::VideoAdvancedServiceConfiguration::mProbeCacheFile,		nap::rtti::EPropertyMetaData::Default, "File that persists video probe results across runs, when empty results are only cached in memory")
+RTTI_END_CLASS
+
 RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoAdvancedService)
 	RTTI_CONSTRUCTOR(nap::ServiceConfiguration*)
 RTTI_END_CLASS
 
 namespace nap
 {
+	rtti::TypeInfo VideoAdvancedServiceConfiguration::getServiceType() const
+	{
+		return RTTI_OF(VideoAdvancedService);
+	}
+
+
 	bool VideoAdvancedService::init(nap::utility::ErrorState& errorState)
 	{
-		//Logger::info("Initializing happlayerService");
+		// Fall back to defaults when no configuration is provided
+		VideoAdvancedServiceConfiguration default_configuration;
+		auto* configuration = getConfiguration<VideoAdvancedServiceConfiguration>();
+		if (configuration == nullptr)
+			configuration = &default_configuration;
+
+		// Create the worker pool that runs all threaded video players
+		mWorkerPool = std::make_unique<VideoWorkerPool>(configuration->mNumWorkerThreads);
+		nap::Logger::info("VideoAdvancedService: decoding on %d worker threads", mWorkerPool->getThreadCount());
+
+		// Create the frame pool
+		if (!errorState.check(configuration->mFramePoolSize >= 0, "FramePoolSize can't be negative"))
+			return false;
+		mFramePool = std::make_unique<VideoFramePool>(configuration->mFramePoolSize, configuration->mFramePoolHugePages);
+
+		// Keyframe index cache
+		mKeyframeIndexDirectory = configuration->mKeyframeIndexDirectory;
+		if (!mKeyframeIndexDirectory.empty() && !utility::dirExists(mKeyframeIndexDirectory))
+		{
+			if (!errorState.check(utility::makeDirs(mKeyframeIndexDirectory), "Unable to create keyframe index directory: %s", mKeyframeIndexDirectory.c_str()))
+				return false;
+		}
+
+		// Load probe results of previous runs, an invalid cache is discarded
+		mProbeCache = std::make_unique<VideoProbeCache>(configuration->mProbeCacheFile);
+		utility::ErrorState cache_error;
+		if (!mProbeCache->load(cache_error))
+			nap::Logger::warn("VideoAdvancedService: %s", cache_error.toString().c_str());
 		return true;
 	}
 
@@ -41,6 +83,18 @@ namespace nap
 
 	void VideoAdvancedService::shutdown()
 	{
+		// All players are stopped at this point, join the workers
+		mWorkerPool.reset();
+		if (mFramePool->getHits() + mFramePool->getMisses() > 0)
+			nap::Logger::debug("VideoAdvancedService: frame pool hits: %llu, misses: %llu", static_cast<unsigned long long>(mFramePool->getHits()), static_cast<unsigned long long>(mFramePool->getMisses()));
+		mFramePool.reset();
+
+		// Persist probe results for the next run
+		utility::ErrorState cache_error;
+		if (!mProbeCache->save(cache_error))
+			nap::Logger::warn("VideoAdvancedService: %s", cache_error.toString().c_str());
+		nap::Logger::debug("VideoAdvancedService: probe cache hits: %llu, misses: %llu", static_cast<unsigned long long>(mProbeCache->getHits()), static_cast<unsigned long long>(mProbeCache->getMisses()));
+		mProbeCache.reset();
 	}
 
 
@@ -1,11 +1,36 @@
 #pragma once
 
+// Local Includes
+#include "videoworkerpool.h"
+#include "videoframepool.h"
+#include "videoprobecache.h"
+
 // External Includes
 #include <nap/service.h>
 
 namespace nap
 {
     class VideoPlayerAdvancedBase;
+    class VideoAdvancedService;
+
+    /**
+     * Video advanced service configuration
+     */
+    class NAPAPI VideoAdvancedServiceConfiguration : public ServiceConfiguration
+    {
+        RTTI_ENABLE(ServiceConfiguration)
+    public:
+        int mNumWorkerThreads = 0;		///< Property: 'NumWorkerThreads' number of threads that decode all threaded video players, 0 means hardware threads minus one
+        int mFramePoolSize = 8;			///< Property: 'FramePoolSize' max number of idle frames kept per pixel format and size
+        bool mFramePoolHugePages = false;	///< Property: 'FramePoolHugePages' back large pooled frames with huge pages, where supported
+        std::string mKeyframeIndexDirectory;	///< Property: 'KeyframeIndexDirectory' directory that holds keyframe index cache files, when empty the cache is stored next to the video file
+        std::string mProbeCacheFile;			///< Property: 'ProbeCacheFile' file that persists video probe results across runs, when empty results are only cached in memory
+
+        /**
+         * @return the service type associated with this configuration
+         */
+        virtual rtti::TypeInfo getServiceType() const override;
+    };
 
 	class NAPAPI VideoAdvancedService : public Service
 	{
@@ -49,7 +74,38 @@ namespace nap
         void removePlayer(VideoPlayerAdvancedBase& player);
 
         void registerObjectCreators(rtti::Factory &factory) override;
+
+        /**
+         * Returns the worker pool that runs the work cycles of all threaded video players.
+         * Only available after initialization.
+         * @return the shared worker pool
+         */
+        VideoWorkerPool& getWorkerPool()						{ assert(mWorkerPool != nullptr); return *mWorkerPool; }
+
+        /**
+         * Returns the pool that recycles video frames, thread safe.
+         * Release frames to this pool instead of freeing them.
+         * Only available after initialization.
+         * @return the shared frame pool
+         */
+        VideoFramePool& getFramePool()						{ assert(mFramePool != nullptr); return *mFramePool; }
+
+        /**
+         * @return directory that holds keyframe index cache files, empty when the cache is stored next to the video file
+         */
+        const std::string& getKeyframeIndexDirectory() const	{ return mKeyframeIndexDirectory; }
+
+        /**
+         * Returns the cache of video probe results, thread safe.
+         * Only available after initialization.
+         * @return the shared probe cache
+         */
+        VideoProbeCache& getProbeCache()						{ assert(mProbeCache != nullptr); return *mProbeCache; }
     private:
         std::vector<VideoPlayerAdvancedBase*> mPlayers;	///< All players
+        std::unique_ptr<VideoWorkerPool> mWorkerPool;		///< Shared worker pool
+        std::unique_ptr<VideoFramePool> mFramePool;		///< Shared frame pool
+        std::string mKeyframeIndexDirectory;			///< Keyframe index cache directory
+        std::unique_ptr<VideoProbeCache> mProbeCache;		///< Shared probe cache
 	};
 }
@@ -0,0 +1,43 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+// External Includes
+#include <shader.h>
+
+namespace nap
+{
+	// Forward declares
+	class Core;
+	class RenderService;
+
+	/**
+	 * Base class of the video shaders of this module.
+	 * Loads the vertex and fragment shader from the 'shaders' directory of the module.
+	 */
+	class NAPAPI VideoAdvancedShader : public Shader
+	{
+		RTTI_ENABLE(Shader)
+	public:
+		/**
+		 * @param core the core instance
+		 * @param vertexShader name of the vertex shader, without extension
+		 * @param fragmentShader name of the fragment shader, without extension
+		 */
+		VideoAdvancedShader(Core& core, const char* vertexShader, const char* fragmentShader);
+
+		/**
+		 * Cross compiles the video GLSL shader code to SPIR-V, creates the shader module and parses all the uniforms and samplers.
+		 * @param errorState contains the error if initialization fails.
+		 * @return if initialization succeeded.
+		 */
+		virtual bool init(utility::ErrorState& errorState) override;
+
+	private:
+		RenderService* mRenderService = nullptr;
+		const char* mVertexShader = nullptr;		///< Name of the vertex shader
+		const char* mFragmentShader = nullptr;		///< Name of the fragment shader
+	};
+}
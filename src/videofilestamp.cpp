@@ -0,0 +1,28 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// Local Includes
+#include "videofilestamp.h"
+
+// External Includes
+#include <filesystem>
+
+namespace nap
+{
+    bool VideoFileStamp::read(const std::string& path, VideoFileStamp& outStamp)
+    {
+        std::error_code error;
+        auto size = std::filesystem::file_size(path, error);
+        if (error)
+            return false;
+
+        auto time = std::filesystem::last_write_time(path, error);
+        if (error)
+            return false;
+
+        outStamp.mSize = static_cast<uint64>(size);
+        outStamp.mTime = static_cast<int64>(time.time_since_epoch().count());
+        return true;
+    }
+}
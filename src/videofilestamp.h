@@ -0,0 +1,33 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+// External Includes
+#include <nap/numeric.h>
+#include <utility/dllexport.h>
+#include <string>
+
+namespace nap
+{
+    /**
+     * Size and modification time of a video file, used to detect stale cache entries.
+     */
+    struct NAPAPI VideoFileStamp
+    {
+        uint64 mSize = 0;           ///< File size in bytes
+        int64 mTime = 0;            ///< File modification time, in file clock ticks
+
+        /**
+         * Reads the size and modification time of a file
+         * @param path path to the file
+         * @param outStamp the stamp of the file
+         * @return if the file exists and its stamp could be read
+         */
+        static bool read(const std::string& path, VideoFileStamp& outStamp);
+
+        bool operator==(const VideoFileStamp& other) const  { return mSize == other.mSize && mTime == other.mTime; }
+        bool operator!=(const VideoFileStamp& other) const  { return !(*this == other); }
+    };
+}
@@ -0,0 +1,239 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// Local Includes
+#include "videoformatconverter.h"
+#include "videopixelformathandler.h"
+#include "videoworkerpool.h"
+#include "videoframepool.h"
+
+// External Includes
+#include <nap/assert.h>
+#include <nap/datetime.h>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+extern "C"
+{
+#include <libavutil/frame.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+namespace nap
+{
+    // Max number of bands a frame is split in
+    static constexpr int sMaxBands = 4;
+
+    // Min number of rows in a band, smaller frames are converted on fewer threads
+    static constexpr int sMinBandHeight = 64;
+
+    // Band boundaries are aligned to this number of rows, a multiple of every vertical chroma subsampling and of the dither pattern
+    static constexpr int sBandAlignment = 16;
+
+    // Number of rows of a neighbouring band that are scaled along, covers the vertical taps of the bilinear chroma filter.
+    // A multiple of the alignment, the overlap doesn't move the chroma siting or the dither pattern of the band.
+    static constexpr int sBandOverlap = 16;
+
+    // Weight of a new measurement in the average conversion time
+    static constexpr double sConversionTimeWeight = 0.05;
+
+
+    VideoFormatConverter::VideoFormatConverter(VideoWorkerPool& workerPool, VideoFramePool& framePool) :
+        mWorkerPool(workerPool), mFramePool(framePool)
+    { }
+
+
+    VideoFormatConverter::~VideoFormatConverter()
+    {
+        clearBands();
+    }
+
+
+    bool VideoFormatConverter::convert(const Frame& frame, Frame& outFrame)
+    {
+        assert(frame.isValid());
+        SteadyTimeStamp start = SteadyClock::now();
+        const AVFrame& src = *frame.mFrame;
+        int dst_format = utility::getVideoConversionFormat(src.format);
+        if (dst_format < 0 || !prepare(src.format, dst_format, src.width, src.height))
+            return false;
+
+        Frame converted = mFramePool.acquire(dst_format, src.width, src.height);
+        if (!converted.isValid())
+            return false;
+
+        // Hand out all bands but the first, which is converted on this thread
+        AVFrame& dst = *converted.mFrame;
+        std::atomic<int> pending = { static_cast<int>(mBands.size()) - 1 };
+        for (size_t i = 1; i < mBands.size(); i++)
+        {
+            const Band& band = mBands[i];
+            mWorkerPool.enqueue([this, &band, &src, &dst, &pending]()
+            {
+                convertBand(band, src, dst);
+                pending.fetch_sub(1, std::memory_order_release);
+            });
+        }
+        convertBand(mBands[0], src, dst);
+
+        // Help out until the other bands are done, the tasks refer to this stack frame.
+        // Helping out nests at most a few tasks deep, see VideoWorkerPool::tryRunPendingTask().
+        while (pending.load(std::memory_order_acquire) > 0)
+        {
+            if (!mWorkerPool.tryRunPendingTask())
+                std::this_thread::yield();
+        }
+
+        converted.mPTSSecs = frame.mPTSSecs;
+        outFrame = converted;
+
+        double conversion_time = std::chrono::duration<double>(SteadyClock::now() - start).count();
+        mConversionTime = mConversionTime > 0.0 ? mConversionTime + (conversion_time - mConversionTime) * sConversionTimeWeight : conversion_time;
+        return true;
+    }
+
+
+    bool VideoFormatConverter::prepare(int srcFormat, int dstFormat, int width, int height)
+    {
+        if (srcFormat == mSrcFormat && dstFormat == mDstFormat && width == mWidth && height == mHeight && !mBands.empty())
+            return true;
+
+        clearBands();
+        mSrcFormat = srcFormat;
+        mDstFormat = dstFormat;
+        mWidth = width;
+        mHeight = height;
+
+        // One band per thread that can help out, including the calling thread
+        int band_count = std::clamp(std::min(mWorkerPool.getThreadCount() + 1, height / sMinBandHeight), 1, sMaxBands);
+        int band_height = (height + band_count - 1) / band_count;
+        band_height = (band_height + sBandAlignment - 1) / sBandAlignment * sBandAlignment;
+        for (int y = 0; y < height; y += band_height)
+        {
+            // The filter clamps at the edge of the scaled rows, which is a seam at a band edge.
+            // Scale the rows around the band along and crop them, the filter clamps at the edge of the frame only.
+            Band band;
+            band.mY = y;
+            band.mHeight = std::min(band_height, height - y);
+            band.mOverlapTop = std::min(sBandOverlap, y);
+            band.mOverlapBottom = std::min(sBandOverlap, height - y - band.mHeight);
+            int scaled_height = band.mHeight + band.mOverlapTop + band.mOverlapBottom;
+            mBands.emplace_back(band);
+
+            Band& added = mBands.back();
+            added.mContext = sws_getContext(width, scaled_height, static_cast<AVPixelFormat>(srcFormat),
+                width, scaled_height, static_cast<AVPixelFormat>(dstFormat), SWS_BILINEAR, nullptr, nullptr, nullptr);
+            added.mScratch = av_frame_alloc();
+            if (added.mContext == nullptr || added.mScratch == nullptr)
+            {
+                clearBands();
+                return false;
+            }
+
+            added.mScratch->format = dstFormat;
+            added.mScratch->width = width;
+            added.mScratch->height = scaled_height;
+            if (av_frame_get_buffer(added.mScratch, 0) < 0)
+            {
+                clearBands();
+                return false;
+            }
+        }
+        return true;
+    }
+
+
+    void VideoFormatConverter::convertBand(const Band& band, const AVFrame& src, AVFrame& dst) const
+    {
+        // Point every source plane at the first scaled row, subsampled chroma planes start at a scaled row.
+        // The palette of paletted formats is not a plane.
+        const AVPixFmtDescriptor* src_descriptor = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(src.format));
+        const AVPixFmtDescriptor* dst_descriptor = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(dst.format));
+        int scaled_y = band.mY - band.mOverlapTop;
+        int scaled_height = band.mHeight + band.mOverlapTop + band.mOverlapBottom;
+        const uint8_t* src_data[4] = { nullptr };
+        for (int i = 0; i < 4; i++)
+        {
+            bool src_palette = i == 1 && (src_descriptor->flags & AV_PIX_FMT_FLAG_PAL) != 0;
+            int src_shift = (i == 1 || i == 2) && (src_descriptor->flags & AV_PIX_FMT_FLAG_RGB) == 0 ? src_descriptor->log2_chroma_h : 0;
+            if (src.data[i] != nullptr)
+                src_data[i] = src_palette ? src.data[i] : src.data[i] + static_cast<ptrdiff_t>(scaled_y >> src_shift) * src.linesize[i];
+        }
+        AVFrame& scratch = *band.mScratch;
+        sws_scale(band.mContext, src_data, src.linesize, 0, scaled_height, scratch.data, scratch.linesize);
+
+        // Crop the overlap, copy the rows of the band to the destination
+        int row_bytes[4] = { 0 };
+        av_image_fill_linesizes(row_bytes, static_cast<AVPixelFormat>(dst.format), dst.width);
+        for (int i = 0; i < av_pix_fmt_count_planes(static_cast<AVPixelFormat>(dst.format)); i++)
+        {
+            int dst_shift = (i == 1 || i == 2) && (dst_descriptor->flags & AV_PIX_FMT_FLAG_RGB) == 0 ? dst_descriptor->log2_chroma_h : 0;
+            const uint8_t* band_rows = scratch.data[i] + static_cast<ptrdiff_t>(band.mOverlapTop >> dst_shift) * scratch.linesize[i];
+            uint8_t* dst_rows = dst.data[i] + static_cast<ptrdiff_t>(band.mY >> dst_shift) * dst.linesize[i];
+            av_image_copy_plane(dst_rows, dst.linesize[i], band_rows, scratch.linesize[i], row_bytes[i], AV_CEIL_RSHIFT(band.mHeight, dst_shift));
+        }
+    }
+
+
+    void VideoFormatConverter::clearBands()
+    {
+        for (auto& band : mBands)
+        {
+            sws_freeContext(band.mContext);
+            av_frame_free(&band.mScratch);
+        }
+        mBands.clear();
+    }
+
+
+    namespace utility
+    {
+        int getVideoConversionFormat(int pixelFormat)
+        {
+            // Supported as-is
+            rtti::TypeInfo handler_type = RTTI_OF(VideoPixelFormatHandlerBase);
+            utility::ErrorState error;
+            if (getVideoPixelFormatHandlerType(pixelFormat, handler_type, error))
+                return pixelFormat;
+
+            // Hardware frames and bitstream formats can't be converted
+            const AVPixFmtDescriptor* descriptor = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(pixelFormat));
+            if (descriptor == nullptr || (descriptor->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BITSTREAM)) != 0)
+                return -1;
+
+            // RGB, paletted and gray with alpha: 8 bit RGB, the output is 8 bit
+            bool alpha = (descriptor->flags & AV_PIX_FMT_FLAG_ALPHA) != 0;
+            if ((descriptor->flags & (AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_PAL)) != 0 || (descriptor->nb_components == 2 && alpha))
+                return alpha || (descriptor->flags & AV_PIX_FMT_FLAG_PAL) != 0 ? AV_PIX_FMT_RGBA : AV_PIX_FMT_RGB0;
+
+            // Gray and YUV keep their bit depth, rounded up to the next supported depth
+            int depth = descriptor->comp[0].depth;
+            int depth_index = depth <= 8 ? 0 : depth <= 10 ? 1 : depth <= 12 ? 2 : 3;
+            if (descriptor->nb_components == 1)
+            {
+                static const AVPixelFormat sGrayFormats[] = { AV_PIX_FMT_GRAY8, AV_PIX_FMT_GRAY10LE, AV_PIX_FMT_GRAY12LE, AV_PIX_FMT_GRAY16LE };
+                return sGrayFormats[depth_index];
+            }
+
+            // YUV keeps its chroma resolution, formats subsampled more than 420 are upsampled to 420
+            int layout_index = descriptor->log2_chroma_w > 0 ? (descriptor->log2_chroma_h > 0 ? 0 : 1) : 2;
+            static const AVPixelFormat sYUVFormats[3][4] =
+            {
+                { AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV420P10LE, AV_PIX_FMT_YUV420P12LE, AV_PIX_FMT_YUV420P16LE },
+                { AV_PIX_FMT_YUV422P, AV_PIX_FMT_YUV422P10LE, AV_PIX_FMT_YUV422P12LE, AV_PIX_FMT_YUV422P16LE },
+                { AV_PIX_FMT_YUV444P, AV_PIX_FMT_YUV444P10LE, AV_PIX_FMT_YUV444P12LE, AV_PIX_FMT_YUV444P16LE }
+            };
+            static const AVPixelFormat sYUVAFormats[3][4] =
+            {
+                { AV_PIX_FMT_YUVA420P, AV_PIX_FMT_YUVA420P10LE, AV_PIX_FMT_YUVA420P16LE, AV_PIX_FMT_YUVA420P16LE },
+                { AV_PIX_FMT_YUVA422P, AV_PIX_FMT_YUVA422P10LE, AV_PIX_FMT_YUVA422P12LE, AV_PIX_FMT_YUVA422P16LE },
+                { AV_PIX_FMT_YUVA444P, AV_PIX_FMT_YUVA444P10LE, AV_PIX_FMT_YUVA444P12LE, AV_PIX_FMT_YUVA444P16LE }
+            };
+            return alpha ? sYUVAFormats[layout_index][depth_index] : sYUVFormats[layout_index][depth_index];
+        }
+    }
+}
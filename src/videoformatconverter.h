@@ -0,0 +1,109 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+// External Includes
+#include <video.h>
+#include <nap/numeric.h>
+#include <utility/dllexport.h>
+#include <vector>
+
+// Forward declares
+struct SwsContext;
+
+namespace nap
+{
+    // Forward declares
+    class VideoWorkerPool;
+    class VideoFramePool;
+
+    /**
+     * Converts frames of a pixel format no pixel format handler supports to the cheapest supported format.
+     * The frame is split in horizontal bands that are converted in parallel, every band has its own scale context.
+     * Bands are scheduled on the worker pool of the service, the calling thread converts the first band and
+     * runs pending pool tasks while waiting for the others. Every band is scaled with a few rows of its neighbours
+     * into a scratch frame and cropped, the filter sees the same rows at a band edge as it does for the whole frame.
+     *
+     * This is a slow path: it's meant to keep unsupported videos playing, re-encode videos that hit it.
+     * Single threaded use only, call on the decode worker.
+     */
+    class NAPAPI VideoFormatConverter final
+    {
+    public:
+        /**
+         * @param workerPool the pool the bands are converted on
+         * @param framePool the pool converted frames are acquired from
+         */
+        VideoFormatConverter(VideoWorkerPool& workerPool, VideoFramePool& framePool);
+
+        /**
+         * Frees the scale contexts and scratch frames
+         */
+        ~VideoFormatConverter();
+
+        /**
+         * Converts a decoded frame to the format returned by utility::getVideoConversionFormat().
+         * The converted frame is acquired from the frame pool, release it to the pool. The decoded frame is not released.
+         * @param frame the frame to convert
+         * @param outFrame the converted frame, with the presentation time of the decoded frame
+         * @return if the frame was converted
+         */
+        bool convert(const Frame& frame, Frame& outFrame);
+
+        /**
+         * @return average time in seconds it takes to convert a frame
+         */
+        double getConversionTime() const                { return mConversionTime; }
+
+    private:
+        /**
+         * Horizontal band of a frame, converted by its own scale context
+         */
+        struct Band
+        {
+            SwsContext* mContext = nullptr;     ///< Scale context, created for the height of the band including the overlap
+            AVFrame* mScratch = nullptr;        ///< Converted band including the overlap, cropped to the destination
+            int mY = 0;                         ///< First row of the band
+            int mHeight = 0;                    ///< Number of rows
+            int mOverlapTop = 0;                ///< Number of rows of the band above that are scaled along
+            int mOverlapBottom = 0;             ///< Number of rows of the band below that are scaled along
+        };
+
+        /**
+         * (Re)creates the bands when the source format or size changes
+         */
+        bool prepare(int srcFormat, int dstFormat, int width, int height);
+
+        /**
+         * Converts a single band
+         */
+        void convertBand(const Band& band, const AVFrame& src, AVFrame& dst) const;
+
+        /**
+         * Frees the scale contexts and scratch frames of all bands
+         */
+        void clearBands();
+
+        VideoWorkerPool& mWorkerPool;           ///< Pool the bands are converted on
+        VideoFramePool& mFramePool;             ///< Pool converted frames are acquired from
+        std::vector<Band> mBands;               ///< Bands of the current format and size
+        int mSrcFormat = -1;                    ///< Source pixel format of the bands
+        int mDstFormat = -1;                    ///< Destination pixel format of the bands
+        int mWidth = 0;                         ///< Frame width of the bands
+        int mHeight = 0;                        ///< Frame height of the bands
+        double mConversionTime = 0.0;           ///< Average conversion time in seconds
+    };
+
+    namespace utility
+    {
+        /**
+         * Returns the pixel format frames of the given format are uploaded as: the format itself when a pixel format handler
+         * supports it, otherwise the cheapest supported format that keeps its chroma resolution, bit depth and alpha.
+         * @param pixelFormat the decoded pixel format
+         * @return the upload pixel format, -1 when frames of this format can't be converted (hardware and bitstream formats)
+         */
+        int NAPAPI getVideoConversionFormat(int pixelFormat);
+    }
+}
@@ -0,0 +1,188 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// Local Includes
+#include "videoframepool.h"
+
+// External Includes
+#include <nap/assert.h>
+#include <cstdlib>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+extern "C"
+{
+#include <libavutil/frame.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/mem.h>
+}
+
+namespace nap
+{
+    // Line alignment of pooled frames, matches the widest SIMD registers used by FFmpeg
+    static constexpr int sLineAlignment = 64;
+
+    // Size of a transparent huge page, buffers smaller than this are allocated regularly
+    static constexpr size_t sHugePageSize = 2 * 1024 * 1024;
+
+
+    static uint64 createKey(int pixelFormat, int width, int height)
+    {
+        return (static_cast<uint64>(pixelFormat & 0xffff) << 48) | (static_cast<uint64>(width & 0xffffff) << 24) | static_cast<uint64>(height & 0xffffff);
+    }
+
+
+    static void freeBuffer(void* opaque, uint8_t* data)
+    {
+        av_free(data);
+    }
+
+
+    static void freeHugePageBuffer(void* opaque, uint8_t* data)
+    {
+        std::free(data);
+    }
+
+
+    /**
+     * Allocates huge page backed memory, returns nullptr when not supported
+     */
+    static uint8_t* allocateHugePages(size_t size)
+    {
+#ifdef __linux__
+        void* data = nullptr;
+        size_t aligned_size = (size + sHugePageSize - 1) & ~(sHugePageSize - 1);
+        if (posix_memalign(&data, sHugePageSize, aligned_size) != 0)
+            return nullptr;
+
+        // Advisory only, the kernel falls back to regular pages when no huge pages are available
+        madvise(data, aligned_size, MADV_HUGEPAGE);
+        return static_cast<uint8_t*>(data);
+#else
+        return nullptr;
+#endif
+    }
+
+
+    VideoFramePool::VideoFramePool(int maxIdleFrames, bool useHugePages) :
+        mMaxIdleFrames(maxIdleFrames), mUseHugePages(useHugePages)
+    { }
+
+
+    VideoFramePool::~VideoFramePool()
+    {
+        for (auto& idle : mIdleFrames)
+        {
+            for (auto* frame : idle.second)
+                av_frame_free(&frame);
+        }
+    }
+
+
+    Frame VideoFramePool::acquire(int pixelFormat, int width, int height)
+    {
+        Frame frame;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto it = mIdleFrames.find(createKey(pixelFormat, width, height));
+            if (it != mIdleFrames.end() && !it->second.empty())
+            {
+                frame.mFrame = it->second.back();
+                it->second.pop_back();
+                mHits.fetch_add(1, std::memory_order_relaxed);
+                return frame;
+            }
+        }
+
+        // Allocate outside of the lock
+        mMisses.fetch_add(1, std::memory_order_relaxed);
+        frame.mFrame = allocateFrame(pixelFormat, width, height);
+        return frame;
+    }
+
+
+    void VideoFramePool::release(Frame& frame)
+    {
+        if (!frame.isValid())
+            return;
+
+        // Not ours, free it: decoder buffers return to the buffer pool of the decoder
+        if (!owns(frame))
+        {
+            frame.free();
+            return;
+        }
+
+        AVFrame* av_frame = frame.mFrame;
+        frame.mFrame = nullptr;
+        av_frame->pts = AV_NOPTS_VALUE;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto& idle = mIdleFrames[createKey(av_frame->format, av_frame->width, av_frame->height)];
+            if (static_cast<int>(idle.size()) < mMaxIdleFrames)
+            {
+                idle.emplace_back(av_frame);
+                return;
+            }
+        }
+        av_frame_free(&av_frame);
+    }
+
+
+    bool VideoFramePool::owns(const Frame& frame) const
+    {
+        return frame.isValid() && frame.mFrame->buf[0] != nullptr && av_buffer_get_opaque(frame.mFrame->buf[0]) == this;
+    }
+
+
+    AVFrame* VideoFramePool::allocateFrame(int pixelFormat, int width, int height)
+    {
+        auto format = static_cast<AVPixelFormat>(pixelFormat);
+        int size = av_image_get_buffer_size(format, width, height, sLineAlignment);
+        if (size <= 0)
+            return nullptr;
+
+        // Allocate all planes in one buffer, large buffers optionally backed by huge pages
+        uint8_t* data = nullptr;
+        auto free_callback = &freeBuffer;
+        if (mUseHugePages && static_cast<size_t>(size) >= sHugePageSize)
+        {
+            data = allocateHugePages(size);
+            free_callback = &freeHugePageBuffer;
+        }
+
+        if (data == nullptr)
+        {
+            data = static_cast<uint8_t*>(av_malloc(size));
+            free_callback = &freeBuffer;
+        }
+
+        if (data == nullptr)
+            return nullptr;
+
+        // The buffer opaque identifies frames owned by this pool
+        AVBufferRef* buffer = av_buffer_create(data, size, free_callback, this, 0);
+        if (buffer == nullptr)
+        {
+            free_callback(this, data);
+            return nullptr;
+        }
+
+        AVFrame* frame = av_frame_alloc();
+        if (frame == nullptr)
+        {
+            av_buffer_unref(&buffer);
+            return nullptr;
+        }
+
+        frame->format = pixelFormat;
+        frame->width  = width;
+        frame->height = height;
+        frame->buf[0] = buffer;
+        av_image_fill_arrays(frame->data, frame->linesize, data, format, width, height, sLineAlignment);
+        return frame;
+    }
+}
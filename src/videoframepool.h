@@ -0,0 +1,88 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+// External Includes
+#include <video.h>
+#include <nap/numeric.h>
+#include <utility/dllexport.h>
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Forward declares
+struct AVFrame;
+
+namespace nap
+{
+    /**
+     * Service wide pool of pre-sized video frames.
+     * Frames are keyed by pixel format and dimensions. Released frames keep their buffers and are handed out again
+     * on the next acquire with the same key, which avoids large allocations and page faults in the frame path.
+     * Large buffers can optionally be backed by transparent huge pages (Linux only).
+     *
+     * Pooled frames are produced on the decode worker of the threaded player: by the VideoFormatConverter for pixel formats
+     * no handler supports, and by the plane transform when no staging buffer is free.
+     * Frames produced by the decoder of a nap::Video are not owned by the pool, their buffers are already recycled
+     * by the internal buffer pool of libavcodec: releasing those frames returns the buffers to the decoder.
+     */
+    class NAPAPI VideoFramePool final
+    {
+    public:
+        /**
+         * @param maxIdleFrames max number of idle frames kept per pixel format and size
+         * @param useHugePages if large frame buffers are backed by huge pages, where supported
+         */
+        VideoFramePool(int maxIdleFrames, bool useHugePages);
+
+        /**
+         * Frees all idle frames, frames that are still in use are freed when released
+         */
+        ~VideoFramePool();
+
+        /**
+         * Returns a frame with allocated buffers, thread safe.
+         * The contents of the frame buffers are undefined.
+         * @param pixelFormat the AVPixelFormat of the frame
+         * @param width width of the frame in pixels
+         * @param height height of the frame in pixels
+         * @return the frame, invalid on allocation failure
+         */
+        Frame acquire(int pixelFormat, int width, int height);
+
+        /**
+         * Releases a frame, thread safe. Frames owned by the pool are recycled, other frames are freed.
+         * The frame is invalid after this call.
+         * @param frame the frame to release
+         */
+        void release(Frame& frame);
+
+        /**
+         * @return if the given frame was acquired from this pool
+         */
+        bool owns(const Frame& frame) const;
+
+        /**
+         * @return number of acquires served from an idle frame
+         */
+        uint64 getHits() const              { return mHits.load(std::memory_order_relaxed); }
+
+        /**
+         * @return number of acquires that required a new allocation
+         */
+        uint64 getMisses() const            { return mMisses.load(std::memory_order_relaxed); }
+
+    private:
+        AVFrame* allocateFrame(int pixelFormat, int width, int height);
+
+        std::mutex mMutex;                                              ///< Guards the idle frames
+        std::unordered_map<uint64, std::vector<AVFrame*>> mIdleFrames;  ///< Idle frames per pixel format and size
+        int mMaxIdleFrames = 0;                                         ///< Max number of idle frames per key
+        bool mUseHugePages = false;                                     ///< If large buffers are backed by huge pages
+        std::atomic<uint64> mHits = { 0 };                              ///< Number of recycled acquires
+        std::atomic<uint64> mMisses = { 0 };                            ///< Number of allocating acquires
+    };
+}
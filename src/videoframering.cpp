@@ -0,0 +1,83 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// Local Includes
+#include "videoframering.h"
+
+// External Includes
+#include <nap/assert.h>
+
+namespace nap
+{
+    VideoFrameRing::~VideoFrameRing()
+    {
+        Entry entry;
+        while (pop(entry))
+        {
+            // Staged frames belong to their staging slot
+            if (entry.mStagingSlot < 0)
+                entry.mFrame.free();
+        }
+    }
+
+
+    void VideoFrameRing::init(int capacity)
+    {
+        assert(capacity > 0);
+        mEntries.resize(capacity);
+        mHead = 0;
+        mTail = 0;
+    }
+
+
+    bool VideoFrameRing::push(const Entry& entry)
+    {
+        uint64 tail = mTail.load(std::memory_order_relaxed);
+        if (tail - mHead.load(std::memory_order_acquire) >= mEntries.size())
+            return false;
+
+        mEntries[tail % mEntries.size()] = entry;
+        mTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+
+    const VideoFrameRing::Entry* VideoFrameRing::peek() const
+    {
+        uint64 head = mHead.load(std::memory_order_relaxed);
+        if (head == mTail.load(std::memory_order_acquire))
+            return nullptr;
+
+        return &mEntries[head % mEntries.size()];
+    }
+
+
+    bool VideoFrameRing::pop(Entry& outEntry)
+    {
+        uint64 head = mHead.load(std::memory_order_relaxed);
+        if (head == mTail.load(std::memory_order_acquire))
+            return false;
+
+        auto& entry = mEntries[head % mEntries.size()];
+        outEntry = entry;
+        entry.mFrame = Frame();
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+
+    bool VideoFrameRing::isFull() const
+    {
+        return mTail.load(std::memory_order_relaxed) - mHead.load(std::memory_order_acquire) >= mEntries.size();
+    }
+
+
+    int VideoFrameRing::size() const
+    {
+        // Load the head first, the tail never falls behind it
+        uint64 head = mHead.load(std::memory_order_acquire);
+        uint64 tail = mTail.load(std::memory_order_acquire);
+        return static_cast<int>(tail - head);
+    }
+}
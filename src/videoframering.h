@@ -0,0 +1,89 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+// External Includes
+#include <video.h>
+#include <nap/numeric.h>
+#include <atomic>
+#include <vector>
+
+namespace nap
+{
+    /**
+     * Bounded single producer, single consumer ring of decoded video frames.
+     * The decode worker pushes frames, stamped with the point in time on the presentation clock at which they should be shown.
+     * The main thread pops the frame that matches its presentation clock. Every entry carries the epoch it was decoded in,
+     * the producer bumps the epoch after a seek or load, which allows the consumer to discard stale frames without
+     * touching the producer side of the ring.
+     */
+    class NAPAPI VideoFrameRing final
+    {
+    public:
+        /**
+         * A decoded frame and the time it should be presented
+         */
+        struct Entry
+        {
+            Frame mFrame;                           ///< The decoded frame, owned by the ring until popped, owned by the staging slot when staged
+            double mPresentationTime = 0.0;         ///< Point in time on the presentation clock the frame is shown
+            uint32 mEpoch = 0;                      ///< Epoch the frame was decoded in
+            int mStagingSlot = -1;                  ///< Staging ring slot that holds a copy of the frame, -1 when not staged
+        };
+
+        VideoFrameRing() = default;
+
+        /**
+         * Frees all frames left in the ring
+         */
+        ~VideoFrameRing();
+
+        /**
+         * Allocates the ring, not thread safe, call before producer and consumer start
+         * @param capacity max number of frames in the ring
+         */
+        void init(int capacity);
+
+        /**
+         * Pushes a frame, producer only
+         * @param entry the frame to push, ownership moves into the ring on success
+         * @return false if the ring is full
+         */
+        bool push(const Entry& entry);
+
+        /**
+         * Returns the oldest entry without removing it, consumer only
+         * @return the oldest entry, nullptr if the ring is empty
+         */
+        const Entry* peek() const;
+
+        /**
+         * Removes the oldest entry, consumer only
+         * @param outEntry the removed entry, ownership of the frame moves to the caller
+         * @return false if the ring is empty
+         */
+        bool pop(Entry& outEntry);
+
+        /**
+         * @return if the ring is full, accurate for the producer
+         */
+        bool isFull() const;
+
+        /**
+         * @return number of frames in the ring, approximate when called concurrently
+         */
+        int size() const;
+
+        /**
+         * @return max number of frames in the ring
+         */
+        int getCapacity() const     { return static_cast<int>(mEntries.size()); }
+
+    private:
+        std::vector<Entry> mEntries;                ///< All ring entries
+        std::atomic<uint64> mHead = { 0 };          ///< Next entry to pop, written by the consumer
+        std::atomic<uint64> mTail = { 0 };          ///< Next entry to push, written by the producer
+    };
+}
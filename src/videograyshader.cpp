@@ -0,0 +1,29 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// Local includes
+#include "videograyshader.h"
+
+// nap::VideoGrayShader run time class definition
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoGrayShader)
+	RTTI_CONSTRUCTOR(nap::Core&)
+RTTI_END_CLASS
+
+
+//////////////////////////////////////////////////////////////////////////
+// VideoGrayShader
+//////////////////////////////////////////////////////////////////////////
+
+namespace nap
+{
+	namespace shader
+	{
+		inline constexpr const char* videogray = "videogray";
+		inline constexpr const char* videograyvert = "videorgba";
+	}
+
+
+	VideoGrayShader::VideoGrayShader(Core& core) : VideoAdvancedShader(core, shader::videograyvert, shader::videogray)
+	{ }
+}
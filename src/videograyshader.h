@@ -0,0 +1,38 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+// Local Includes
+#include "videoadvancedshader.h"
+
+namespace nap
+{
+	// Video shader uniform and sampler names
+	namespace uniform
+	{
+		namespace videogray
+		{
+			inline constexpr const char* uboStruct = "UBO";
+			inline constexpr const char* sampleScale = "sampleScale";
+			inline constexpr const char* outputChannel = "outputChannel";
+
+			namespace sampler
+			{
+				inline constexpr const char* GraySampler = "grayTexture";
+			}
+		}
+	}
+
+	/**
+	 * Video shader for rendering single channel grayscale video frames, of any bit depth.
+	 * Replicates the value to RGB, or writes it to the channel selected by 'outputChannel'.
+	 */
+	class NAPAPI VideoGrayShader : public VideoAdvancedShader
+	{
+		RTTI_ENABLE(VideoAdvancedShader)
+	public:
+		VideoGrayShader(Core& core);
+	};
+}
@@ -0,0 +1,241 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// Local Includes
+#include "videokeyframeindex.h"
+
+// External Includes
+#include <utility/fileutils.h>
+#include <utility/stringutils.h>
+#include <nap/assert.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+
+extern "C"
+{
+#include <libavformat/avformat.h>
+}
+
+namespace nap
+{
+    // Cache file identification
+    static constexpr uint32 sCacheMagic = 0x4946474b;     // 'KGFI'
+    static constexpr uint32 sCacheVersion = 1;
+
+    // Longest video path accepted from a cache file
+    static constexpr uint32 sMaxPathLength = 32768;
+
+    // File extension of cache files
+    static constexpr const char* sCacheExtension = "napkfi";
+
+
+    template<typename T>
+    static void writeValue(std::ofstream& stream, const T& value)
+    {
+        stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+
+    template<typename T>
+    static bool readValue(std::ifstream& stream, T& value)
+    {
+        return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+
+
+    VideoKeyframeIndex::~VideoKeyframeIndex()
+    {
+        if (mFormatContext != nullptr)
+            avformat_close_input(&mFormatContext);
+    }
+
+
+    bool VideoKeyframeIndex::open(const std::string& path, utility::ErrorState& errorState)
+    {
+        assert(mFormatContext == nullptr);
+        if (!errorState.check(VideoFileStamp::read(path, mFileStamp), "Unable to read file: %s", path.c_str()))
+            return false;
+
+        if (!errorState.check(avformat_open_input(&mFormatContext, path.c_str(), nullptr, nullptr) == 0, "Unable to open file: %s", path.c_str()))
+            return false;
+
+        // Find the video stream
+        mStreamIndex = -1;
+        if (avformat_find_stream_info(mFormatContext, nullptr) >= 0)
+            mStreamIndex = av_find_best_stream(mFormatContext, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+
+        if (!errorState.check(mStreamIndex >= 0, "Unable to find video stream in file: %s", path.c_str()))
+        {
+            avformat_close_input(&mFormatContext);
+            return false;
+        }
+
+        // Don't demux other streams
+        for (unsigned int i = 0; i < mFormatContext->nb_streams; i++)
+            mFormatContext->streams[i]->discard = static_cast<int>(i) == mStreamIndex ? AVDISCARD_DEFAULT : AVDISCARD_ALL;
+
+        AVStream* stream = mFormatContext->streams[mStreamIndex];
+        AVRational frame_rate = av_guess_frame_rate(mFormatContext, stream, nullptr);
+        mFrameRate = frame_rate.num > 0 && frame_rate.den > 0 ? av_q2d(frame_rate) : 0.0;
+        mTimeBase = av_q2d(stream->time_base);
+        mStartTime = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+        mKeyframes.clear();
+        mFrameCount = 0;
+        mPath = path;
+        return true;
+    }
+
+
+    bool VideoKeyframeIndex::build(int maxPackets, bool& outFinished)
+    {
+        assert(mFormatContext != nullptr);
+        outFinished = false;
+
+        // Read the next batch of packets of the video stream, keep track of the keyframes
+        AVPacket* packet = av_packet_alloc();
+        int result = 0;
+        for (int i = 0; i < maxPackets; i++)
+        {
+            result = av_read_frame(mFormatContext, packet);
+            if (result < 0)
+                break;
+
+            if (packet->stream_index == mStreamIndex)
+            {
+                mFrameCount++;
+                int64 timestamp = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+                if ((packet->flags & AV_PKT_FLAG_KEY) != 0 && timestamp != AV_NOPTS_VALUE)
+                    mKeyframes.emplace_back(static_cast<double>(timestamp - mStartTime) * mTimeBase);
+            }
+            av_packet_unref(packet);
+        }
+        av_packet_free(&packet);
+
+        // More packets to read
+        if (result >= 0)
+            return true;
+
+        // Done, the demuxer returns packets in decode order, keyframes are sorted by presentation time
+        avformat_close_input(&mFormatContext);
+        std::sort(mKeyframes.begin(), mKeyframes.end());
+        outFinished = true;
+        return result == AVERROR_EOF;
+    }
+
+
+    bool VideoKeyframeIndex::load(const std::string& cachePath, const std::string& path, utility::ErrorState& errorState)
+    {
+        std::ifstream stream(cachePath, std::ios::binary | std::ios::ate);
+        if (!errorState.check(stream.is_open(), "Unable to open keyframe index: %s", cachePath.c_str()))
+            return false;
+
+        // Sizes read from the file are checked against the bytes that are left, a corrupt file can't trigger huge allocations
+        auto file_size = static_cast<uint64>(stream.tellg());
+        stream.seekg(0);
+        auto remaining = [&stream, file_size]()
+        {
+            auto position = stream.tellg();
+            return position < 0 ? uint64(0) : file_size - std::min(static_cast<uint64>(position), file_size);
+        };
+
+        uint32 magic = 0, version = 0;
+        if (!errorState.check(readValue(stream, magic) && readValue(stream, version) && magic == sCacheMagic && version == sCacheVersion,
+            "Invalid keyframe index: %s", cachePath.c_str()))
+            return false;
+
+        // Validate the cache against the video file
+        uint32 path_length = 0;
+        if (!errorState.check(readValue(stream, path_length) && path_length <= sMaxPathLength && path_length <= remaining(),
+            "Invalid keyframe index: %s", cachePath.c_str()))
+            return false;
+
+        std::string cached_path(path_length, '\0');
+        VideoFileStamp file_stamp, cached_stamp;
+        if (!errorState.check(stream.read(cached_path.data(), path_length) && readValue(stream, cached_stamp.mSize) && readValue(stream, cached_stamp.mTime),
+            "Invalid keyframe index: %s", cachePath.c_str()))
+            return false;
+
+        if (!errorState.check(VideoFileStamp::read(path, file_stamp), "Unable to read file: %s", path.c_str()))
+            return false;
+
+        if (!errorState.check(cached_path == path && cached_stamp == file_stamp, "Keyframe index is stale: %s", cachePath.c_str()))
+            return false;
+
+        // Read the index, the members are only replaced when all of it is valid
+        double frame_rate = 0.0;
+        int64 frame_count = 0;
+        uint64 keyframe_count = 0;
+        if (!errorState.check(readValue(stream, frame_rate) && readValue(stream, frame_count) && readValue(stream, keyframe_count) &&
+            keyframe_count <= remaining() / sizeof(double), "Invalid keyframe index: %s", cachePath.c_str()))
+            return false;
+
+        std::vector<double> keyframes(keyframe_count);
+        stream.read(reinterpret_cast<char*>(keyframes.data()), keyframe_count * sizeof(double));
+        if (!errorState.check(static_cast<bool>(stream) && std::is_sorted(keyframes.begin(), keyframes.end()), "Invalid keyframe index: %s", cachePath.c_str()))
+            return false;
+
+        mPath = path;
+        mFileStamp = file_stamp;
+        mFrameRate = frame_rate;
+        mFrameCount = frame_count;
+        mKeyframes = std::move(keyframes);
+        return true;
+    }
+
+
+    bool VideoKeyframeIndex::save(const std::string& cachePath, utility::ErrorState& errorState) const
+    {
+        // Write to a temporary file first, a concurrent reader never sees a partial index
+        std::string temp_path = cachePath + ".tmp";
+        {
+            std::ofstream stream(temp_path, std::ios::binary | std::ios::trunc);
+            if (!errorState.check(stream.is_open(), "Unable to write keyframe index: %s", cachePath.c_str()))
+                return false;
+
+            writeValue(stream, sCacheMagic);
+            writeValue(stream, sCacheVersion);
+            writeValue(stream, static_cast<uint32>(mPath.size()));
+            stream.write(mPath.data(), mPath.size());
+            writeValue(stream, mFileStamp.mSize);
+            writeValue(stream, mFileStamp.mTime);
+            writeValue(stream, mFrameRate);
+            writeValue(stream, mFrameCount);
+            writeValue(stream, static_cast<uint64>(mKeyframes.size()));
+            stream.write(reinterpret_cast<const char*>(mKeyframes.data()), mKeyframes.size() * sizeof(double));
+            if (!errorState.check(static_cast<bool>(stream), "Unable to write keyframe index: %s", cachePath.c_str()))
+                return false;
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temp_path, cachePath, error);
+        return errorState.check(!error, "Unable to write keyframe index: %s", cachePath.c_str());
+    }
+
+
+    std::string VideoKeyframeIndex::getCachePath(const std::string& path, const std::string& cacheDirectory)
+    {
+        // Sidecar next to the video file
+        if (cacheDirectory.empty())
+            return utility::appendFileExtension(path, sCacheExtension);
+
+        // Cache directory, file name is derived from the full path of the video file
+        std::string name = utility::stringFormat("%016llx", static_cast<unsigned long long>(std::hash<std::string>()(path)));
+        return utility::joinPath({ cacheDirectory, utility::appendFileExtension(name, sCacheExtension) });
+    }
+
+
+    double VideoKeyframeIndex::findKeyframe(double seconds) const
+    {
+        auto it = std::upper_bound(mKeyframes.begin(), mKeyframes.end(), seconds);
+        return it == mKeyframes.begin() ? 0.0 : *(it - 1);
+    }
+
+
+    double VideoKeyframeIndex::frameToSeconds(int64 frame) const
+    {
+        return mFrameRate > 0.0 ? static_cast<double>(frame) / mFrameRate : 0.0;
+    }
+}
@@ -0,0 +1,121 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+// Local Includes
+#include "videofilestamp.h"
+
+// External Includes
+#include <nap/numeric.h>
+#include <utility/errorstate.h>
+#include <string>
+#include <vector>
+
+// Forward declares
+struct AVFormatContext;
+
+namespace nap
+{
+    /**
+     * Index of all keyframes in the video stream of a file.
+     * The index is built incrementally by demuxing the file once, without decoding, and can be persisted to a cache file.
+     * A cache file is keyed by the path, size and modification time of the video file, a stale cache file is ignored.
+     * Used by the threaded video player to seek to the keyframe that precedes a frame,
+     * instead of relying on the demuxer to find it.
+     */
+    class NAPAPI VideoKeyframeIndex final
+    {
+    public:
+        VideoKeyframeIndex() = default;
+
+        /**
+         * Closes the file if the index is being built
+         */
+        ~VideoKeyframeIndex();
+
+        /**
+         * Opens a video file to build the index from, follow up with calls to build() until it's finished.
+         * @param path path to the video file
+         * @param errorState contains the error if the file can't be opened
+         * @return if the file was opened
+         */
+        bool open(const std::string& path, utility::ErrorState& errorState);
+
+        /**
+         * Builds the index incrementally by reading the next batch of packets of the video stream.
+         * Building in batches allows the caller to spread the work over time, without blocking a worker for a long time.
+         * The file is closed when the index is finished.
+         * @param maxPackets max number of packets to read
+         * @param outFinished set to true when all packets are read
+         * @return if reading the packets succeeded
+         */
+        bool build(int maxPackets, bool& outFinished);
+
+        /**
+         * Loads the index from a cache file, fails if the cache does not match the video file.
+         * @param cachePath path to the cache file
+         * @param path path to the video file the index belongs to
+         * @param errorState contains the error if the index can't be loaded
+         * @return if the index was loaded
+         */
+        bool load(const std::string& cachePath, const std::string& path, utility::ErrorState& errorState);
+
+        /**
+         * Saves the index to a cache file
+         * @param cachePath path to the cache file
+         * @param errorState contains the error if the index can't be saved
+         * @return if the index was saved
+         */
+        bool save(const std::string& cachePath, utility::ErrorState& errorState) const;
+
+        /**
+         * Returns the cache file path for a video file.
+         * @param path path to the video file
+         * @param cacheDirectory directory that holds all cache files, when empty the cache file is stored next to the video file
+         * @return the cache file path
+         */
+        static std::string getCachePath(const std::string& path, const std::string& cacheDirectory);
+
+        /**
+         * @param seconds time in seconds
+         * @return time in seconds of the last keyframe at or before the given time, 0 when there is none
+         */
+        double findKeyframe(double seconds) const;
+
+        /**
+         * @param frame frame number, starting at 0
+         * @return presentation time of the frame in seconds, relative to the start of the stream
+         */
+        double frameToSeconds(int64 frame) const;
+
+        /**
+         * @return frame rate of the video stream
+         */
+        double getFrameRate() const                     { return mFrameRate; }
+
+        /**
+         * @return number of frames in the video stream
+         */
+        int64 getFrameCount() const                     { return mFrameCount; }
+
+        /**
+         * @return number of keyframes in the video stream
+         */
+        int getKeyframeCount() const                    { return static_cast<int>(mKeyframes.size()); }
+
+    private:
+        std::string mPath;                              ///< Path of the indexed file
+        VideoFileStamp mFileStamp;                      ///< Size and modification time of the indexed file
+        double mFrameRate = 0.0;                        ///< Frame rate of the video stream
+        int64 mFrameCount = 0;                          ///< Number of frames in the video stream
+        std::vector<double> mKeyframes;                 ///< Sorted keyframe times in seconds, relative to the start of the stream
+
+        // Build state
+        AVFormatContext* mFormatContext = nullptr;      ///< Demuxer, only open while building
+        int mStreamIndex = -1;                          ///< Index of the video stream
+        double mTimeBase = 0.0;                         ///< Time base of the video stream in seconds
+        int64 mStartTime = 0;                           ///< Start time of the video stream in time base units
+    };
+}
@@ -0,0 +1,29 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// Local includes
+#include "videonv12shader.h"
+
+// nap::VideoNV12Shader run time class definition
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoNV12Shader)
+	RTTI_CONSTRUCTOR(nap::Core&)
+RTTI_END_CLASS
+
+
+//////////////////////////////////////////////////////////////////////////
+// VideoNV12Shader
+//////////////////////////////////////////////////////////////////////////
+
+namespace nap
+{
+	namespace shader
+	{
+		inline constexpr const char* videonv12 = "videonv12";
+		inline constexpr const char* videonv12vert = "videorgba";
+	}
+
+
+	VideoNV12Shader::VideoNV12Shader(Core& core) : VideoAdvancedShader(core, shader::videonv12vert, shader::videonv12)
+	{ }
+}
@@ -0,0 +1,35 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+// Local Includes
+#include "videoadvancedshader.h"
+
+namespace nap
+{
+	// Video shader sampler names
+	namespace uniform
+	{
+		namespace videonv12
+		{
+			namespace sampler
+			{
+				inline constexpr const char* YSampler  = "yTexture";
+				inline constexpr const char* UVSampler = "uvTexture";
+			}
+		}
+	}
+
+	/**
+	 * Video shader for rendering semi-planar YUV 420 video frames: a luma plane and an interleaved chroma plane (NV12, P010).
+	 * The chroma plane is a single channel texture of twice the chroma width, the shader de-interleaves and filters it.
+	 */
+	class NAPAPI VideoNV12Shader : public VideoAdvancedShader
+	{
+		RTTI_ENABLE(VideoAdvancedShader)
+	public:
+		VideoNV12Shader(Core& core);
+	};
+}
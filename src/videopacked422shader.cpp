@@ -0,0 +1,29 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// Local includes
+#include "videopacked422shader.h"
+
+// nap::VideoPacked422Shader run time class definition
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPacked422Shader)
+	RTTI_CONSTRUCTOR(nap::Core&)
+RTTI_END_CLASS
+
+
+//////////////////////////////////////////////////////////////////////////
+// VideoPacked422Shader
+//////////////////////////////////////////////////////////////////////////
+
+namespace nap
+{
+	namespace shader
+	{
+		inline constexpr const char* videopacked422 = "videopacked422";
+		inline constexpr const char* videopacked422vert = "videorgba";
+	}
+
+
+	VideoPacked422Shader::VideoPacked422Shader(Core& core) : VideoAdvancedShader(core, shader::videopacked422vert, shader::videopacked422)
+	{ }
+}
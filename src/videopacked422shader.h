@@ -0,0 +1,37 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+// Local Includes
+#include "videoadvancedshader.h"
+
+namespace nap
+{
+	// Video shader uniform and sampler names
+	namespace uniform
+	{
+		namespace videopacked422
+		{
+			inline constexpr const char* uboStruct = "UBO";
+			inline constexpr const char* packedLayout = "packedLayout";
+
+			namespace sampler
+			{
+				inline constexpr const char* PackedSampler = "packedTexture";
+			}
+		}
+	}
+
+	/**
+	 * Video shader for rendering packed 4:2:2 YUV video frames (UYVY, YUYV, YVYU), uploaded as-is.
+	 * Every RGBA texel holds two pixels, the shader unpacks and filters luma and chroma.
+	 */
+	class NAPAPI VideoPacked422Shader : public VideoAdvancedShader
+	{
+		RTTI_ENABLE(VideoAdvancedShader)
+	public:
+		VideoPacked422Shader(Core& core);
+	};
+}
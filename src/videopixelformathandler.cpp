@@ -1,18 +1,25 @@
 #include "videopixelformathandler.h"
 #include "videoadvancedservice.h"
 #include "videorgbashader.h"
+#include "videonv12shader.h"
+#include "videoyuvshader.h"
+#include "videograyshader.h"
+#include "videopacked422shader.h"
+#include "videostagingring.h"
+#include "videoplanetransform.h"
 #include "renderglobals.h"
 
 #include <video.h>
 #include <nap/core.h>
 #include <renderservice.h>
-#include <videoshader.h>
+#include <algorithm>
 
 extern "C"
 {
 #include <libavcodec/avcodec.h>
 #include <libavformat/avformat.h>
 #include <libavutil/pixfmt.h>
+#include <libavutil/pixdesc.h>
 #include "libswresample/swresample.h"
 }
 
@@ -27,7 +34,35 @@ RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUV420P8Handler)
         RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
 RTTI_END_CLASS
 
-RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUV444P16Handler)
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUV422P8Handler)
+        RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
+RTTI_END_CLASS
+
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUV444P8Handler)
+        RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
+RTTI_END_CLASS
+
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUV420P10Handler)
+        RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
+RTTI_END_CLASS
+
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUV422P10Handler)
+        RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
+RTTI_END_CLASS
+
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUV444P10Handler)
+        RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
+RTTI_END_CLASS
+
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUV420P12Handler)
+        RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
+RTTI_END_CLASS
+
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUV422P12Handler)
+        RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
+RTTI_END_CLASS
+
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUV444P12Handler)
         RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
 RTTI_END_CLASS
 
@@ -35,6 +70,70 @@ RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUV420P16Handler)
         RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
 RTTI_END_CLASS
 
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUV422P16Handler)
+        RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
+RTTI_END_CLASS
+
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUV444P16Handler)
+        RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
+RTTI_END_CLASS
+
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUVA420P8Handler)
+        RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
+RTTI_END_CLASS
+
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUVA422P8Handler)
+        RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
+RTTI_END_CLASS
+
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUVA444P8Handler)
+        RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
+RTTI_END_CLASS
+
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUVA420P10Handler)
+        RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
+RTTI_END_CLASS
+
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUVA422P10Handler)
+        RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
+RTTI_END_CLASS
+
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUVA444P10Handler)
+        RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
+RTTI_END_CLASS
+
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUVA422P12Handler)
+        RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
+RTTI_END_CLASS
+
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUVA444P12Handler)
+        RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
+RTTI_END_CLASS
+
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUVA420P16Handler)
+        RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
+RTTI_END_CLASS
+
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUVA422P16Handler)
+        RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
+RTTI_END_CLASS
+
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatYUVA444P16Handler)
+        RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
+RTTI_END_CLASS
+
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatNV12Handler)
+        RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
+RTTI_END_CLASS
+
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatGrayHandler)
+        RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
+RTTI_END_CLASS
+
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPixelFormatPacked422Handler)
+        RTTI_CONSTRUCTOR(nap::VideoAdvancedService&, int)
+RTTI_END_CLASS
+
 namespace nap
 {
     //////////////////////////////////////////////////////////////////////////
@@ -46,6 +145,111 @@ namespace nap
     { }
 
 
+    VideoPixelFormatHandlerBase::~VideoPixelFormatHandlerBase()
+    {
+        discardStagedFrame();
+    }
+
+
+    bool VideoPixelFormatHandlerBase::stage(VideoStagingRing& ring, int slot)
+    {
+        // Every plane needs a texture, rows must consist of whole texels
+        std::array<Texture2D*, VideoStagingRing::maxPlanes> textures;
+        const auto& staged = ring.getSlot(slot);
+        if(getPlaneTextures(textures) != staged.mPlaneCount)
+            return false;
+
+        for(int i = 0; i < staged.mPlaneCount; i++)
+        {
+            int texel_size = textures[i]->getDescriptor().getBytesPerPixel();
+            if(texel_size <= 0 || staged.mPlanes[i].mRowBytes % texel_size != 0)
+                return false;
+        }
+
+        // The previous frame was never recorded, it's replaced
+        discardStagedFrame();
+        mStagingRing = &ring;
+        mStagedSlot = slot;
+        return true;
+    }
+
+
+    void VideoPixelFormatHandlerBase::recordUpload(VkCommandBuffer commandBuffer)
+    {
+        mStagingActive = true;
+        if(mStagingRing == nullptr)
+            return;
+
+        std::array<Texture2D*, VideoStagingRing::maxPlanes> textures;
+        const auto& staged = mStagingRing->getSlot(mStagedSlot);
+        int plane_count = getPlaneTextures(textures);
+        assert(plane_count == staged.mPlaneCount);
+
+        // Wait for previous frames to finish sampling the textures, then make them writable
+        std::array<VkImageMemoryBarrier, VideoStagingRing::maxPlanes> barriers;
+        for(int i = 0; i < plane_count; i++)
+        {
+            auto& barrier = barriers[i];
+            barrier = {};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = textures[i]->getHandle().getImage();
+            barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+        }
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0, 0, nullptr, 0, nullptr, plane_count, barriers.data());
+
+        // One copy per plane, the staged rows can be wider or longer than the texture when the size is odd
+        for(int i = 0; i < plane_count; i++)
+        {
+            const auto& plane = staged.mPlanes[i];
+            uint32 row_length = plane.mRowBytes / static_cast<uint32>(textures[i]->getDescriptor().getBytesPerPixel());
+
+            VkBufferImageCopy region = {};
+            region.bufferOffset = plane.mOffset;
+            region.bufferRowLength = row_length;
+            region.bufferImageHeight = plane.mRows;
+            region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+            region.imageOffset = { 0, 0, 0 };
+            region.imageExtent = { std::min<uint32>(textures[i]->getWidth(), row_length), std::min<uint32>(textures[i]->getHeight(), plane.mRows), 1 };
+            vkCmdCopyBufferToImage(commandBuffer, staged.mBuffer, barriers[i].image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        }
+
+        // Make the textures readable again
+        for(int i = 0; i < plane_count; i++)
+        {
+            auto& barrier = barriers[i];
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        }
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0, 0, nullptr, 0, nullptr, plane_count, barriers.data());
+
+        // The buffer is reused once the GPU finished this frame
+        mStagingRing->markInFlight(mStagedSlot);
+        mStagingRing = nullptr;
+        mStagedSlot = -1;
+    }
+
+
+    void VideoPixelFormatHandlerBase::discardStagedFrame()
+    {
+        if(mStagingRing == nullptr)
+            return;
+
+        mStagingRing->release(mStagedSlot);
+        mStagingRing = nullptr;
+        mStagedSlot = -1;
+    }
+
+
     nap::UniformMat4Instance* VideoPixelFormatHandlerBase::ensureUniform(const std::string& uniformName, utility::ErrorState& error)
     {
         assert(mMVPStruct != nullptr);
@@ -126,12 +330,24 @@ namespace nap
 
         // Get sampler inputs to update from video material
         mSampler = ensureSampler(uniform::videorgba::sampler::RGBASampler, errorState);
-        mSampler->setTexture(*mTexture);
-
         if (!errorState.check(mSampler != nullptr, "Unable to find sampler: %s in material: %s",
                               uniform::videorgba::sampler::RGBASampler, mMaterialInstance.getMaterial().mID.c_str()))
             return false;
 
+        mSampler->setTexture(*mTexture);
+
+        // Channel order and alpha are handled by the shader, the frame is uploaded as-is
+        UniformStructInstance* ubo = mMaterialInstance.getOrCreateUniform(uniform::videorgba::uboStruct);
+        auto* swap_red_blue = ubo != nullptr ? ubo->getOrCreateUniform<UniformIntInstance>(uniform::videorgba::swapRedBlue) : nullptr;
+        auto* opaque = ubo != nullptr ? ubo->getOrCreateUniform<UniformIntInstance>(uniform::videorgba::opaque) : nullptr;
+        if (!errorState.check(swap_red_blue != nullptr && opaque != nullptr, "Unable to find uniforms: %s, %s in material: %s",
+                              uniform::videorgba::swapRedBlue, uniform::videorgba::opaque, mMaterialInstance.getMaterial().mID.c_str()))
+            return false;
+
+        bool bgr = mPixelFormat == AV_PIX_FMT_BGRA || mPixelFormat == AV_PIX_FMT_BGR0 || mPixelFormat == AV_PIX_FMT_BGR24;
+        bool has_alpha = mPixelFormat == AV_PIX_FMT_RGBA || mPixelFormat == AV_PIX_FMT_BGRA;
+        swap_red_blue->setValue(bgr ? 1 : 0);
+        opaque->setValue(has_alpha ? 0 : 1);
         return true;
     }
 
@@ -179,21 +395,40 @@ namespace nap
 
     void VideoPixelFormatRGBAP8Handler::update(Frame& frame)
     {
-        // Copy data into texture
+        // Expand 3 byte pixels the decode worker did not expand
         assert(mTexture != nullptr);
+        if(frame.mFrame->format == AV_PIX_FMT_RGB24 || frame.mFrame->format == AV_PIX_FMT_BGR24)
+        {
+            int row_bytes = mTexture->getWidth() * 4;
+            mExpandBuffer.resize(static_cast<size_t>(row_bytes) * mTexture->getHeight());
+            utility::expandRGB24Plane(frame.mFrame->data[0], frame.mFrame->linesize[0], mExpandBuffer.data(), row_bytes, mTexture->getWidth(), mTexture->getHeight());
+            mTexture->update(mExpandBuffer.data(), mTexture->getWidth(), mTexture->getHeight(), row_bytes, ESurfaceChannels::RGBA);
+            return;
+        }
+
+        // Copy data into texture
         mTexture->update(frame.mFrame->data[0], mTexture->getWidth(), mTexture->getHeight(), frame.mFrame->linesize[0], ESurfaceChannels::RGBA);
     }
 
+
+    int VideoPixelFormatRGBAP8Handler::getPlaneTextures(std::array<Texture2D*, 4>& outTextures)
+    {
+        outTextures[0] = mTexture.get();
+        return 1;
+    }
+
     //////////////////////////////////////////////////////////////////////////
-    //// VideoPixelFormatYUV420P8Handler
+    //// VideoPixelFormatYUVHandler
     //////////////////////////////////////////////////////////////////////////
 
-    VideoPixelFormatYUV420P8Handler::VideoPixelFormatYUV420P8Handler(VideoAdvancedService& service, int pixelFormat) :
+    template<int ChromaShiftX, int ChromaShiftY, int BitDepth, bool Alpha>
+    VideoPixelFormatYUVHandler<ChromaShiftX, ChromaShiftY, BitDepth, Alpha>::VideoPixelFormatYUVHandler(VideoAdvancedService& service, int pixelFormat) :
             VideoPixelFormatHandlerBase(service, pixelFormat)
     { }
 
 
-    bool VideoPixelFormatYUV420P8Handler::init(utility::ErrorState& errorState)
+    template<int ChromaShiftX, int ChromaShiftY, int BitDepth, bool Alpha>
+    bool VideoPixelFormatYUVHandler<ChromaShiftX, ChromaShiftY, BitDepth, Alpha>::init(utility::ErrorState& errorState)
     {
         if(!VideoPixelFormatHandlerBase::init(errorState))
             return false;
@@ -203,40 +438,69 @@ namespace nap
             return false;
 
         // Get sampler inputs to update from video material
-        mYSampler = ensureSampler(uniform::video::sampler::YSampler, errorState);
-        mUSampler = ensureSampler(uniform::video::sampler::USampler, errorState);
-        mVSampler = ensureSampler(uniform::video::sampler::VSampler, errorState);
+        mYSampler = ensureSampler(uniform::videoyuv::sampler::YSampler, errorState);
+        mUSampler = ensureSampler(uniform::videoyuv::sampler::USampler, errorState);
+        mVSampler = ensureSampler(uniform::videoyuv::sampler::VSampler, errorState);
 
         if (!errorState.check(mYSampler != nullptr, "Unable to find sampler: %s in material: %s",
-                              uniform::video::sampler::YSampler, mMaterialInstance.getMaterial().mID.c_str()))
+                              uniform::videoyuv::sampler::YSampler, mMaterialInstance.getMaterial().mID.c_str()))
             return false;
 
         if (!errorState.check(mUSampler != nullptr, "Unable to find sampler: %s in material: %s",
-                              uniform::video::sampler::USampler, mMaterialInstance.getMaterial().mID.c_str()))
+                              uniform::videoyuv::sampler::USampler, mMaterialInstance.getMaterial().mID.c_str()))
             return false;
 
         if (!errorState.check(mVSampler != nullptr, "Unable to find sampler: %s in material: %s",
-                              uniform::video::sampler::VSampler, mMaterialInstance.getMaterial().mID.c_str()))
+                              uniform::videoyuv::sampler::VSampler, mMaterialInstance.getMaterial().mID.c_str()))
             return false;
 
         mYSampler->setTexture(*mYTexture);
         mUSampler->setTexture(*mUTexture);
         mVSampler->setTexture(*mVTexture);
 
+        if constexpr (Alpha)
+        {
+            mASampler = ensureSampler(uniform::videoyuv::sampler::ASampler, errorState);
+            if (!errorState.check(mASampler != nullptr, "Unable to find sampler: %s in material: %s",
+                                  uniform::videoyuv::sampler::ASampler, mMaterialInstance.getMaterial().mID.c_str()))
+                return false;
+            mASampler->setTexture(*mATexture);
+        }
+
+        // Samples of less than 16 bits are stored in the low bits of a 16 bit texture, scale them to the full range
+        UniformStructInstance* ubo = mMaterialInstance.getOrCreateUniform(uniform::videoyuv::uboStruct);
+        auto* sample_scale = ubo != nullptr ? ubo->getOrCreateUniform<UniformFloatInstance>(uniform::videoyuv::sampleScale) : nullptr;
+        if (!errorState.check(sample_scale != nullptr, "Unable to find uniform: %s in material: %s",
+                              uniform::videoyuv::sampleScale, mMaterialInstance.getMaterial().mID.c_str()))
+            return false;
+
+        constexpr int container_bits = BitDepth > 8 ? 16 : 8;
+        sample_scale->setValue(static_cast<float>((1 << container_bits) - 1) / static_cast<float>((1 << BitDepth) - 1));
+
+        // Straight alpha by default, the render component selects premultiplied output
+        if constexpr (Alpha)
+        {
+            mPremultiplyAlphaUniform = ubo->getOrCreateUniform<UniformIntInstance>(uniform::videoyuv::premultiplyAlpha);
+            if (!errorState.check(mPremultiplyAlphaUniform != nullptr, "Unable to find uniform: %s in material: %s",
+                                  uniform::videoyuv::premultiplyAlpha, mMaterialInstance.getMaterial().mID.c_str()))
+                return false;
+            mPremultiplyAlphaUniform->setValue(0);
+        }
         return true;
     }
 
 
-    bool VideoPixelFormatYUV420P8Handler::initTextures(const glm::vec2& size, utility::ErrorState& errorState)
+    template<int ChromaShiftX, int ChromaShiftY, int BitDepth, bool Alpha>
+    bool VideoPixelFormatYUVHandler<ChromaShiftX, ChromaShiftY, BitDepth, Alpha>::initTextures(const glm::vec2& size, utility::ErrorState& errorState)
     {
-        if(mYTexture == nullptr || mYTexture->getWidth() != static_cast<uint32_t>(size.x) || mYTexture->getHeight() != static_cast<uint32_t>(size.y))
+        if(mYTexture == nullptr || mYTexture->getWidth() != static_cast<int>(size.x) || mYTexture->getHeight() != static_cast<int>(size.y))
         {
             // Create texture description
             SurfaceDescriptor tex_description;
-            tex_description.mWidth = static_cast<uint32_t>(size.x);
-            tex_description.mHeight = static_cast<uint32_t>(size.y);
+            tex_description.mWidth = static_cast<int>(size.x);
+            tex_description.mHeight = static_cast<int>(size.y);
             tex_description.mColorSpace = EColorSpace::Linear;
-            tex_description.mDataType = ESurfaceDataType::BYTE;
+            tex_description.mDataType = BitDepth > 8 ? ESurfaceDataType::USHORT : ESurfaceDataType::BYTE;
             tex_description.mChannels = ESurfaceChannels::R;
 
             // Create Y Texture
@@ -245,11 +509,18 @@ namespace nap
             if (!mYTexture->init(tex_description, false, 0, errorState))
                 return false;
 
-            // Update dimensions for U and V texture
-            float uv_x = size.x * 0.5f;
-            float uv_y = size.y * 0.5f;
-            tex_description.mWidth  = static_cast<uint32_t>(uv_x);
-            tex_description.mHeight = static_cast<uint32_t>(uv_y);
+            // Alpha is stored at full resolution
+            if constexpr (Alpha)
+            {
+                mATexture = std::make_unique<Texture2D>(mService.getCore());
+                mATexture->mUsage = Texture::EUsage::DynamicWrite;
+                if (!mATexture->init(tex_description, false, 0, errorState))
+                    return false;
+            }
+
+            // Subsampled chroma planes are rounded up, like the planes of the decoder
+            tex_description.mWidth  = (static_cast<int>(size.x) + (1 << ChromaShiftX) - 1) >> ChromaShiftX;
+            tex_description.mHeight = (static_cast<int>(size.y) + (1 << ChromaShiftY) - 1) >> ChromaShiftY;
 
             // Create U
             mUTexture = std::make_unique<Texture2D>(mService.getCore());
@@ -273,62 +544,116 @@ namespace nap
         if(mVSampler!= nullptr)
             mVSampler->setTexture(*mVTexture);
 
+        if(mASampler!= nullptr)
+            mASampler->setTexture(*mATexture);
+
         return true;
     }
 
 
-    void VideoPixelFormatYUV420P8Handler::clearTextures()
+    template<int ChromaShiftX, int ChromaShiftY, int BitDepth, bool Alpha>
+    void VideoPixelFormatYUVHandler<ChromaShiftX, ChromaShiftY, BitDepth, Alpha>::clearTextures()
     {
         if(!mYTexture)
             return;
 
-        auto vid_x  = static_cast<float>(mYTexture->getWidth());
-        auto vid_y  = static_cast<float>(mYTexture->getHeight());
-        float uv_x = vid_x * 0.5f;
-        float uv_y = vid_y * 0.5f;
-
-        // YUV420p to RGB conversion uses an 'offset' value of (-0.0625, -0.5, -0.5) in the shader.
+        // YUV to RGB conversion uses an 'offset' value of (-0.0625, -0.5, -0.5) in the shader.
         // This means that initializing the YUV planes to zero does not actually result in black output.
-        // To fix this, we initialize the YUV planes to the negative of the offset
-        std::vector<uint8_t> y_default_data(static_cast<size_t>(vid_x * vid_y), 16);
+        // To fix this, we initialize the YUV planes to the negative of the offset, at the bit depth of the samples
+        std::vector<SampleType> y_default_data(static_cast<size_t>(mYTexture->getWidth()) * mYTexture->getHeight(), static_cast<SampleType>(16 << (BitDepth - 8)));
+        std::vector<SampleType> uv_default_data(static_cast<size_t>(mUTexture->getWidth()) * mUTexture->getHeight(), static_cast<SampleType>(128 << (BitDepth - 8)));
 
-        // Initialize UV planes
-        std::vector<uint8_t> uv_default_data(static_cast<size_t>(uv_x * uv_y), 127);
+        mYTexture->update(y_default_data.data(), mYTexture->getWidth(), mYTexture->getHeight(), mYTexture->getWidth() * static_cast<int>(sizeof(SampleType)), ESurfaceChannels::R);
+        mUTexture->update(uv_default_data.data(), mUTexture->getWidth(), mUTexture->getHeight(), mUTexture->getWidth() * static_cast<int>(sizeof(SampleType)), ESurfaceChannels::R);
+        mVTexture->update(uv_default_data.data(), mVTexture->getWidth(), mVTexture->getHeight(), mVTexture->getWidth() * static_cast<int>(sizeof(SampleType)), ESurfaceChannels::R);
 
-        mYTexture->update(y_default_data.data(), mYTexture->getWidth(), mYTexture->getHeight(), mYTexture->getWidth(), ESurfaceChannels::R);
-        mUTexture->update(uv_default_data.data(), mUTexture->getWidth(), mUTexture->getHeight(), mUTexture->getWidth(), ESurfaceChannels::R);
-        mVTexture->update(uv_default_data.data(), mVTexture->getWidth(), mVTexture->getHeight(), mVTexture->getWidth(), ESurfaceChannels::R);
+        // Opaque black
+        if constexpr (Alpha)
+        {
+            std::vector<SampleType> a_default_data(static_cast<size_t>(mATexture->getWidth()) * mATexture->getHeight(), static_cast<SampleType>((1 << BitDepth) - 1));
+            mATexture->update(a_default_data.data(), mATexture->getWidth(), mATexture->getHeight(), mATexture->getWidth() * static_cast<int>(sizeof(SampleType)), ESurfaceChannels::R);
+        }
     }
 
 
-    void VideoPixelFormatYUV420P8Handler::update(Frame& frame)
+    template<int ChromaShiftX, int ChromaShiftY, int BitDepth, bool Alpha>
+    void VideoPixelFormatYUVHandler<ChromaShiftX, ChromaShiftY, BitDepth, Alpha>::update(Frame& frame)
     {
-        // Copy data into texture
         // Copy data into texture
         assert(mYTexture != nullptr);
         mYTexture->update(frame.mFrame->data[0], mYTexture->getWidth(), mYTexture->getHeight(), frame.mFrame->linesize[0], ESurfaceChannels::R);
         mUTexture->update(frame.mFrame->data[1], mUTexture->getWidth(), mUTexture->getHeight(), frame.mFrame->linesize[1], ESurfaceChannels::R);
         mVTexture->update(frame.mFrame->data[2], mVTexture->getWidth(), mVTexture->getHeight(), frame.mFrame->linesize[2], ESurfaceChannels::R);
+        if constexpr (Alpha)
+            mATexture->update(frame.mFrame->data[3], mATexture->getWidth(), mATexture->getHeight(), frame.mFrame->linesize[3], ESurfaceChannels::R);
+    }
+
+
+    template<int ChromaShiftX, int ChromaShiftY, int BitDepth, bool Alpha>
+    int VideoPixelFormatYUVHandler<ChromaShiftX, ChromaShiftY, BitDepth, Alpha>::getPlaneTextures(std::array<Texture2D*, 4>& outTextures)
+    {
+        outTextures[0] = mYTexture.get();
+        outTextures[1] = mUTexture.get();
+        outTextures[2] = mVTexture.get();
+        if constexpr (Alpha)
+        {
+            outTextures[3] = mATexture.get();
+            return 4;
+        }
+        return 3;
     }
 
 
-    Material* VideoPixelFormatYUV420P8Handler::getOrCreateMaterial(utility::ErrorState& errorState)
+    template<int ChromaShiftX, int ChromaShiftY, int BitDepth, bool Alpha>
+    Material* VideoPixelFormatYUVHandler<ChromaShiftX, ChromaShiftY, BitDepth, Alpha>::getOrCreateMaterial(utility::ErrorState& errorState)
     {
-        return mService.getCore().getService<RenderService>()->getOrCreateMaterial<VideoShader>(errorState);
+        if constexpr (Alpha)
+            return mService.getCore().getService<RenderService>()->getOrCreateMaterial<VideoYUVAShader>(errorState);
+        return mService.getCore().getService<RenderService>()->getOrCreateMaterial<VideoYUVShader>(errorState);
     }
 
+
+    // Planar YUV handlers
+    template class VideoPixelFormatYUVHandler<1, 1, 8>;
+    template class VideoPixelFormatYUVHandler<1, 0, 8>;
+    template class VideoPixelFormatYUVHandler<0, 0, 8>;
+    template class VideoPixelFormatYUVHandler<1, 1, 10>;
+    template class VideoPixelFormatYUVHandler<1, 0, 10>;
+    template class VideoPixelFormatYUVHandler<0, 0, 10>;
+    template class VideoPixelFormatYUVHandler<1, 1, 12>;
+    template class VideoPixelFormatYUVHandler<1, 0, 12>;
+    template class VideoPixelFormatYUVHandler<0, 0, 12>;
+    template class VideoPixelFormatYUVHandler<1, 1, 16>;
+    template class VideoPixelFormatYUVHandler<1, 0, 16>;
+    template class VideoPixelFormatYUVHandler<0, 0, 16>;
+
+    // Planar YUV handlers with alpha
+    template class VideoPixelFormatYUVHandler<1, 1, 8, true>;
+    template class VideoPixelFormatYUVHandler<1, 0, 8, true>;
+    template class VideoPixelFormatYUVHandler<0, 0, 8, true>;
+    template class VideoPixelFormatYUVHandler<1, 1, 10, true>;
+    template class VideoPixelFormatYUVHandler<1, 0, 10, true>;
+    template class VideoPixelFormatYUVHandler<0, 0, 10, true>;
+    template class VideoPixelFormatYUVHandler<1, 0, 12, true>;
+    template class VideoPixelFormatYUVHandler<0, 0, 12, true>;
+    template class VideoPixelFormatYUVHandler<1, 1, 16, true>;
+    template class VideoPixelFormatYUVHandler<1, 0, 16, true>;
+    template class VideoPixelFormatYUVHandler<0, 0, 16, true>;
+
     //////////////////////////////////////////////////////////////////////////
-    //// VideoPixelFormatYUV444P16Handler
+    //// VideoPixelFormatNV12Handler
     //////////////////////////////////////////////////////////////////////////
 
-    VideoPixelFormatYUV444P16Handler::VideoPixelFormatYUV444P16Handler(VideoAdvancedService& service, int pixelFormat) :
+    VideoPixelFormatNV12Handler::VideoPixelFormatNV12Handler(VideoAdvancedService& service, int pixelFormat) :
             VideoPixelFormatHandlerBase(service, pixelFormat)
-    { }
+    {
+        mBytesPerSample = pixelFormat == AV_PIX_FMT_NV12 ? 1 : 2;
+    }
 
 
-    bool VideoPixelFormatYUV444P16Handler::init(utility::ErrorState& errorState)
+    bool VideoPixelFormatNV12Handler::init(utility::ErrorState& errorState)
     {
-        if (!VideoPixelFormatHandlerBase::init(errorState))
+        if(!VideoPixelFormatHandlerBase::init(errorState))
             return false;
 
         // Initialize texture with dummy data
@@ -336,31 +661,25 @@ namespace nap
             return false;
 
         // Get sampler inputs to update from video material
-        mYSampler = ensureSampler(uniform::video::sampler::YSampler, errorState);
-        mUSampler = ensureSampler(uniform::video::sampler::USampler, errorState);
-        mVSampler = ensureSampler(uniform::video::sampler::VSampler, errorState);
+        mYSampler = ensureSampler(uniform::videonv12::sampler::YSampler, errorState);
+        mUVSampler = ensureSampler(uniform::videonv12::sampler::UVSampler, errorState);
 
         if (!errorState.check(mYSampler != nullptr, "Unable to find sampler: %s in material: %s",
-                              uniform::video::sampler::YSampler, mMaterialInstance.getMaterial().mID.c_str()))
+                              uniform::videonv12::sampler::YSampler, mMaterialInstance.getMaterial().mID.c_str()))
             return false;
 
-        if (!errorState.check(mUSampler != nullptr, "Unable to find sampler: %s in material: %s",
-                              uniform::video::sampler::USampler, mMaterialInstance.getMaterial().mID.c_str()))
-            return false;
-
-        if (!errorState.check(mVSampler != nullptr, "Unable to find sampler: %s in material: %s",
-                              uniform::video::sampler::VSampler, mMaterialInstance.getMaterial().mID.c_str()))
+        if (!errorState.check(mUVSampler != nullptr, "Unable to find sampler: %s in material: %s",
+                              uniform::videonv12::sampler::UVSampler, mMaterialInstance.getMaterial().mID.c_str()))
             return false;
 
         mYSampler->setTexture(*mYTexture);
-        mUSampler->setTexture(*mUTexture);
-        mVSampler->setTexture(*mVTexture);
+        mUVSampler->setTexture(*mUVTexture);
 
         return true;
     }
 
 
-    bool VideoPixelFormatYUV444P16Handler::initTextures(const glm::vec2& size, utility::ErrorState& errorState)
+    bool VideoPixelFormatNV12Handler::initTextures(const glm::vec2& size, utility::ErrorState& errorState)
     {
         if(mYTexture == nullptr || mYTexture->getWidth() != static_cast<int>(size.x) || mYTexture->getHeight() != static_cast<int>(size.y))
         {
@@ -369,7 +688,7 @@ namespace nap
             tex_description.mWidth = static_cast<int>(size.x);
             tex_description.mHeight = static_cast<int>(size.y);
             tex_description.mColorSpace = EColorSpace::Linear;
-            tex_description.mDataType = ESurfaceDataType::USHORT;
+            tex_description.mDataType = mBytesPerSample == 1 ? ESurfaceDataType::BYTE : ESurfaceDataType::USHORT;
             tex_description.mChannels = ESurfaceChannels::R;
 
             // Create Y Texture
@@ -378,88 +697,90 @@ namespace nap
             if (!mYTexture->init(tex_description, false, 0, errorState))
                 return false;
 
-            // Update dimensions for U and V texture
-            float uv_x = size.x;
-            float uv_y = size.y;
-            tex_description.mWidth  = static_cast<uint32_t>(uv_x);
-            tex_description.mHeight = static_cast<uint32_t>(uv_y);
-
-            // Create U
-            mUTexture = std::make_unique<Texture2D>(mService.getCore());
-            mUTexture->mUsage = Texture::EUsage::DynamicWrite;
-            if (!mUTexture->init(tex_description, false, 0, errorState))
-                return false;
-
-            // Create V Texture
-            mVTexture = std::make_unique<Texture2D>(mService.getCore());
-            mVTexture->mUsage = Texture::EUsage::DynamicWrite;
-            if (!mVTexture->init(tex_description, false, 0, errorState))
+            // The chroma plane holds a U and V sample for every 2x2 block of pixels, rounded up,
+            // stored in a single channel texture that is twice as wide as the chroma plane
+            int uv_x = (static_cast<int>(size.x) + 1) / 2;
+            int uv_y = (static_cast<int>(size.y) + 1) / 2;
+            tex_description.mWidth  = uv_x * 2;
+            tex_description.mHeight = uv_y;
+
+            // Create UV Texture
+            mUVTexture = std::make_unique<Texture2D>(mService.getCore());
+            mUVTexture->mUsage = Texture::EUsage::DynamicWrite;
+            if (!mUVTexture->init(tex_description, false, 0, errorState))
                 return false;
         }
 
         if(mYSampler!= nullptr)
             mYSampler->setTexture(*mYTexture);
 
-        if(mUSampler!= nullptr)
-            mUSampler->setTexture(*mUTexture);
-
-        if(mVSampler!= nullptr)
-            mVSampler->setTexture(*mVTexture);
+        if(mUVSampler!= nullptr)
+            mUVSampler->setTexture(*mUVTexture);
 
         return true;
     }
 
 
-    void VideoPixelFormatYUV444P16Handler::clearTextures()
+    void VideoPixelFormatNV12Handler::clearTextures()
     {
         if(!mYTexture)
             return;
 
-        auto vid_x  = static_cast<float>(mYTexture->getWidth());
-        auto vid_y  = static_cast<float>(mYTexture->getHeight());
-        float uv_x = vid_x;
-        float uv_y = vid_y;
-
-        // YUV420p to RGB conversion uses an 'offset' value of (-0.0625, -0.5, -0.5) in the shader.
-        // This means that initializing the YUV planes to zero does not actually result in black output.
-        // To fix this, we initialize the YUV planes to the negative of the offset
-        std::vector<uint8_t> y_default_data(static_cast<size_t>(vid_x * vid_y * 2), 0);
-
-        // Initialize UV planes
-        std::vector<uint8_t> uv_default_data(static_cast<size_t>(uv_x * uv_y * 2), 0);
+        // Black is the negative of the 'offset' of (-0.0625, -0.5, -0.5) in the shader,
+        // 16 bit samples hold the value in the high bits
+        size_t y_count = static_cast<size_t>(mYTexture->getWidth()) * mYTexture->getHeight();
+        size_t uv_count = static_cast<size_t>(mUVTexture->getWidth()) * mUVTexture->getHeight();
+        if(mBytesPerSample == 1)
+        {
+            std::vector<uint8_t> y_default_data(y_count, 16);
+            std::vector<uint8_t> uv_default_data(uv_count, 128);
+            mYTexture->update(y_default_data.data(), mYTexture->getWidth(), mYTexture->getHeight(), mYTexture->getWidth(), ESurfaceChannels::R);
+            mUVTexture->update(uv_default_data.data(), mUVTexture->getWidth(), mUVTexture->getHeight(), mUVTexture->getWidth(), ESurfaceChannels::R);
+            return;
+        }
 
+        std::vector<uint16_t> y_default_data(y_count, static_cast<uint16_t>(16 << 8));
+        std::vector<uint16_t> uv_default_data(uv_count, static_cast<uint16_t>(128 << 8));
         mYTexture->update(y_default_data.data(), mYTexture->getWidth(), mYTexture->getHeight(), mYTexture->getWidth() * 2, ESurfaceChannels::R);
-        mUTexture->update(uv_default_data.data(), mUTexture->getWidth(), mUTexture->getHeight(), mUTexture->getWidth() * 2, ESurfaceChannels::R);
-        mVTexture->update(uv_default_data.data(), mVTexture->getWidth(), mVTexture->getHeight(), mVTexture->getWidth() * 2, ESurfaceChannels::R);
+        mUVTexture->update(uv_default_data.data(), mUVTexture->getWidth(), mUVTexture->getHeight(), mUVTexture->getWidth() * 2, ESurfaceChannels::R);
     }
 
 
-    void VideoPixelFormatYUV444P16Handler::update(Frame& frame)
+    void VideoPixelFormatNV12Handler::update(Frame& frame)
     {
-        // Copy data into texture
         // Copy data into texture
         assert(mYTexture != nullptr);
         mYTexture->update(frame.mFrame->data[0], mYTexture->getWidth(), mYTexture->getHeight(), frame.mFrame->linesize[0], ESurfaceChannels::R);
-        mUTexture->update(frame.mFrame->data[1], mUTexture->getWidth(), mUTexture->getHeight(), frame.mFrame->linesize[1], ESurfaceChannels::R);
-        mVTexture->update(frame.mFrame->data[2], mVTexture->getWidth(), mVTexture->getHeight(), frame.mFrame->linesize[2], ESurfaceChannels::R);
+        mUVTexture->update(frame.mFrame->data[1], mUVTexture->getWidth(), mUVTexture->getHeight(), frame.mFrame->linesize[1], ESurfaceChannels::R);
     }
 
 
-    Material* VideoPixelFormatYUV444P16Handler::getOrCreateMaterial(utility::ErrorState& errorState)
+    int VideoPixelFormatNV12Handler::getPlaneTextures(std::array<Texture2D*, 4>& outTextures)
     {
-        return mService.getCore().getService<RenderService>()->getOrCreateMaterial<VideoShader>(errorState);
+        outTextures[0] = mYTexture.get();
+        outTextures[1] = mUVTexture.get();
+        return 2;
+    }
+
+
+    Material* VideoPixelFormatNV12Handler::getOrCreateMaterial(utility::ErrorState& errorState)
+    {
+        return mService.getCore().getService<RenderService>()->getOrCreateMaterial<VideoNV12Shader>(errorState);
     }
 
     //////////////////////////////////////////////////////////////////////////
-    //// VideoPixelFormatYUV420P16Handler
+    //// VideoPixelFormatGrayHandler
     //////////////////////////////////////////////////////////////////////////
 
-    VideoPixelFormatYUV420P16Handler::VideoPixelFormatYUV420P16Handler(VideoAdvancedService& service, int pixelFormat) :
+    VideoPixelFormatGrayHandler::VideoPixelFormatGrayHandler(VideoAdvancedService& service, int pixelFormat) :
             VideoPixelFormatHandlerBase(service, pixelFormat)
-    { }
+    {
+        const AVPixFmtDescriptor* descriptor = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(pixelFormat));
+        mBitDepth = descriptor != nullptr ? descriptor->comp[0].depth : 8;
+    }
 
 
-    bool VideoPixelFormatYUV420P16Handler::init(utility::ErrorState& errorState)
+    bool VideoPixelFormatGrayHandler::init(utility::ErrorState& errorState)
     {
         if(!VideoPixelFormatHandlerBase::init(errorState))
             return false;
@@ -468,174 +789,325 @@ namespace nap
         if (!initTextures({2, 2}, errorState))
             return false;
 
-        // Get sampler inputs to update from video material
-        mYSampler = ensureSampler(uniform::video::sampler::YSampler, errorState);
-        mUSampler = ensureSampler(uniform::video::sampler::USampler, errorState);
-        mVSampler = ensureSampler(uniform::video::sampler::VSampler, errorState);
-
-        if (!errorState.check(mYSampler != nullptr, "Unable to find sampler: %s in material: %s",
-                              uniform::video::sampler::YSampler, mMaterialInstance.getMaterial().mID.c_str()))
+        // Get sampler input to update from video material
+        mSampler = ensureSampler(uniform::videogray::sampler::GraySampler, errorState);
+        if (!errorState.check(mSampler != nullptr, "Unable to find sampler: %s in material: %s",
+                              uniform::videogray::sampler::GraySampler, mMaterialInstance.getMaterial().mID.c_str()))
             return false;
 
-        if (!errorState.check(mUSampler != nullptr, "Unable to find sampler: %s in material: %s",
-                              uniform::video::sampler::USampler, mMaterialInstance.getMaterial().mID.c_str()))
-            return false;
+        mSampler->setTexture(*mTexture);
 
-        if (!errorState.check(mVSampler != nullptr, "Unable to find sampler: %s in material: %s",
-                              uniform::video::sampler::VSampler, mMaterialInstance.getMaterial().mID.c_str()))
+        // Samples of less than 16 bits are stored in the low bits of a 16 bit texture, scale them to the full range
+        UniformStructInstance* ubo = mMaterialInstance.getOrCreateUniform(uniform::videogray::uboStruct);
+        auto* sample_scale = ubo != nullptr ? ubo->getOrCreateUniform<UniformFloatInstance>(uniform::videogray::sampleScale) : nullptr;
+        if (!errorState.check(sample_scale != nullptr, "Unable to find uniform: %s in material: %s",
+                              uniform::videogray::sampleScale, mMaterialInstance.getMaterial().mID.c_str()))
             return false;
 
-        mYSampler->setTexture(*mYTexture);
-        mUSampler->setTexture(*mUTexture);
-        mVSampler->setTexture(*mVTexture);
+        int container_bits = mBitDepth > 8 ? 16 : 8;
+        sample_scale->setValue(static_cast<float>((1 << container_bits) - 1) / static_cast<float>((1 << mBitDepth) - 1));
+
+        // Replicated to RGB by default, the render component selects the output channel
+        mGrayscaleOutputUniform = ubo->getOrCreateUniform<UniformIntInstance>(uniform::videogray::outputChannel);
+        if (!errorState.check(mGrayscaleOutputUniform != nullptr, "Unable to find uniform: %s in material: %s",
+                              uniform::videogray::outputChannel, mMaterialInstance.getMaterial().mID.c_str()))
+            return false;
 
+        mGrayscaleOutputUniform->setValue(0);
         return true;
     }
 
 
-    bool VideoPixelFormatYUV420P16Handler::initTextures(const glm::vec2& size, utility::ErrorState& errorState)
+    bool VideoPixelFormatGrayHandler::initTextures(const glm::vec2& size, utility::ErrorState& errorState)
     {
-        if(mYTexture == nullptr || mYTexture->getWidth() != static_cast<uint32_t>(size.x) || mYTexture->getHeight() != static_cast<uint32_t>(size.y))
+        if(mTexture == nullptr || mTexture->getWidth() != static_cast<int>(size.x) || mTexture->getHeight() != static_cast<int>(size.y))
         {
             // Create texture description
             SurfaceDescriptor tex_description;
-            tex_description.mWidth = static_cast<uint32_t>(size.x);
-            tex_description.mHeight = static_cast<uint32_t>(size.y);
+            tex_description.mWidth = static_cast<int>(size.x);
+            tex_description.mHeight = static_cast<int>(size.y);
             tex_description.mColorSpace = EColorSpace::Linear;
-            tex_description.mDataType = ESurfaceDataType::USHORT;
+            tex_description.mDataType = mBitDepth > 8 ? ESurfaceDataType::USHORT : ESurfaceDataType::BYTE;
             tex_description.mChannels = ESurfaceChannels::R;
 
-            // Create Y Texture
-            mYTexture = std::make_unique<Texture2D>(mService.getCore());
-            mYTexture->mUsage = Texture::EUsage::DynamicWrite;
-            if (!mYTexture->init(tex_description, false, 0, errorState))
+            // Create texture
+            mTexture = std::make_unique<Texture2D>(mService.getCore());
+            mTexture->mUsage = Texture::EUsage::DynamicWrite;
+            if (!mTexture->init(tex_description, false, 0, errorState))
                 return false;
+        }
 
-            // Update dimensions for U and V texture
-            float uv_x = size.x * 0.5f;
-            float uv_y = size.y * 0.5f;
-            tex_description.mWidth  = static_cast<uint32_t>(uv_x);
-            tex_description.mHeight = static_cast<uint32_t>(uv_y);
+        if(mSampler != nullptr)
+            mSampler->setTexture(*mTexture);
 
-            // Create U
-            mUTexture = std::make_unique<Texture2D>(mService.getCore());
-            mUTexture->mUsage = Texture::EUsage::DynamicWrite;
-            if (!mUTexture->init(tex_description, false, 0, errorState))
-                return false;
+        return true;
+    }
 
-            // Create V Texture
-            mVTexture = std::make_unique<Texture2D>(mService.getCore());
-            mVTexture->mUsage = Texture::EUsage::DynamicWrite;
-            if (!mVTexture->init(tex_description, false, 0, errorState))
-                return false;
-        }
 
-        if(mYSampler!= nullptr)
-            mYSampler->setTexture(*mYTexture);
+    void VideoPixelFormatGrayHandler::clearTextures()
+    {
+        if(!mTexture)
+            return;
 
-        if(mUSampler!= nullptr)
-            mUSampler->setTexture(*mUTexture);
+        // Black
+        int bytes_per_sample = mBitDepth > 8 ? 2 : 1;
+        std::vector<uint8_t> default_data(static_cast<size_t>(mTexture->getWidth()) * mTexture->getHeight() * bytes_per_sample, 0);
+        mTexture->update(default_data.data(), mTexture->getWidth(), mTexture->getHeight(), mTexture->getWidth() * bytes_per_sample, ESurfaceChannels::R);
+    }
 
-        if(mVSampler!= nullptr)
-            mVSampler->setTexture(*mVTexture);
 
+    void VideoPixelFormatGrayHandler::update(Frame& frame)
+    {
+        // Copy data into texture
+        assert(mTexture != nullptr);
+        mTexture->update(frame.mFrame->data[0], mTexture->getWidth(), mTexture->getHeight(), frame.mFrame->linesize[0], ESurfaceChannels::R);
+    }
+
+
+    int VideoPixelFormatGrayHandler::getPlaneTextures(std::array<Texture2D*, 4>& outTextures)
+    {
+        outTextures[0] = mTexture.get();
+        return 1;
+    }
+
+
+    Material* VideoPixelFormatGrayHandler::getOrCreateMaterial(utility::ErrorState& errorState)
+    {
+        return mService.getCore().getService<RenderService>()->getOrCreateMaterial<VideoGrayShader>(errorState);
+    }
+
+    //////////////////////////////////////////////////////////////////////////
+    //// VideoPixelFormatPacked422Handler
+    //////////////////////////////////////////////////////////////////////////
+
+    VideoPixelFormatPacked422Handler::VideoPixelFormatPacked422Handler(VideoAdvancedService& service, int pixelFormat) :
+            VideoPixelFormatHandlerBase(service, pixelFormat)
+    {
+        mPackedLayout = pixelFormat == AV_PIX_FMT_YUYV422 ? 1 : pixelFormat == AV_PIX_FMT_YVYU422 ? 2 : 0;
+    }
+
+
+    bool VideoPixelFormatPacked422Handler::init(utility::ErrorState& errorState)
+    {
+        if(!VideoPixelFormatHandlerBase::init(errorState))
+            return false;
+
+        // Initialize texture with dummy data
+        if (!initTextures({2, 2}, errorState))
+            return false;
+
+        // Get sampler input to update from video material
+        mSampler = ensureSampler(uniform::videopacked422::sampler::PackedSampler, errorState);
+        if (!errorState.check(mSampler != nullptr, "Unable to find sampler: %s in material: %s",
+                              uniform::videopacked422::sampler::PackedSampler, mMaterialInstance.getMaterial().mID.c_str()))
+            return false;
+
+        mSampler->setTexture(*mTexture);
+
+        // Tell the shader where the samples are in a texel
+        UniformStructInstance* ubo = mMaterialInstance.getOrCreateUniform(uniform::videopacked422::uboStruct);
+        auto* packed_layout = ubo != nullptr ? ubo->getOrCreateUniform<UniformIntInstance>(uniform::videopacked422::packedLayout) : nullptr;
+        if (!errorState.check(packed_layout != nullptr, "Unable to find uniform: %s in material: %s",
+                              uniform::videopacked422::packedLayout, mMaterialInstance.getMaterial().mID.c_str()))
+            return false;
+
+        packed_layout->setValue(mPackedLayout);
         return true;
     }
 
 
-    void VideoPixelFormatYUV420P16Handler::clearTextures()
+    bool VideoPixelFormatPacked422Handler::initTextures(const glm::vec2& size, utility::ErrorState& errorState)
     {
-        if(!mYTexture)
-            return;
+        // Every texel holds two pixels, odd widths are rounded up like the chroma of the decoder
+        int width = (static_cast<int>(size.x) + 1) / 2;
+        int height = static_cast<int>(size.y);
+        if(mTexture == nullptr || mTexture->getWidth() != width || mTexture->getHeight() != height)
+        {
+            // Create texture description
+            SurfaceDescriptor tex_description;
+            tex_description.mWidth = width;
+            tex_description.mHeight = height;
+            tex_description.mColorSpace = EColorSpace::Linear;
+            tex_description.mDataType = ESurfaceDataType::BYTE;
+            tex_description.mChannels = ESurfaceChannels::RGBA;
+
+            // Create texture
+            mTexture = std::make_unique<Texture2D>(mService.getCore());
+            mTexture->mUsage = Texture::EUsage::DynamicWrite;
+            if (!mTexture->init(tex_description, false, 0, errorState))
+                return false;
+        }
 
-        auto vid_x  = static_cast<float>(mYTexture->getWidth());
-        auto vid_y  = static_cast<float>(mYTexture->getHeight());
-        float uv_x = vid_x * 0.5f;
-        float uv_y = vid_y * 0.5f;
+        if(mSampler != nullptr)
+            mSampler->setTexture(*mTexture);
 
-        // YUV420p to RGB conversion uses an 'offset' value of (-0.0625, -0.5, -0.5) in the shader.
-        // This means that initializing the YUV planes to zero does not actually result in black output.
-        // To fix this, we initialize the YUV planes to the negative of the offset
-        std::vector<uint8_t> y_default_data(static_cast<size_t>(vid_x * vid_y * 2), 0);
+        return true;
+    }
 
-        // Initialize UV planes
-        std::vector<uint8_t> uv_default_data(static_cast<size_t>(uv_x * uv_y * 2), 0);
 
-        mYTexture->update(y_default_data.data(), mYTexture->getWidth(), mYTexture->getHeight(), mYTexture->getWidth() * 2, ESurfaceChannels::R);
-        mUTexture->update(uv_default_data.data(), mUTexture->getWidth(), mUTexture->getHeight(), mUTexture->getWidth() * 2, ESurfaceChannels::R);
-        mVTexture->update(uv_default_data.data(), mVTexture->getWidth(), mVTexture->getHeight(), mVTexture->getWidth() * 2, ESurfaceChannels::R);
+    void VideoPixelFormatPacked422Handler::clearTextures()
+    {
+        if(!mTexture)
+            return;
+
+        // Black is the negative of the 'offset' of (-0.0625, -0.5, -0.5) in the shader, in the byte order of the format
+        static const uint8_t sBlack[3][4] =
+        {
+            { 128, 16, 128, 16 },   // UYVY
+            { 16, 128, 16, 128 },   // YUYV
+            { 16, 128, 16, 128 }    // YVYU
+        };
+
+        size_t texel_count = static_cast<size_t>(mTexture->getWidth()) * mTexture->getHeight();
+        std::vector<uint8_t> default_data(texel_count * 4);
+        for(size_t i = 0; i < texel_count; i++)
+            std::copy(sBlack[mPackedLayout], sBlack[mPackedLayout] + 4, default_data.data() + i * 4);
+
+        mTexture->update(default_data.data(), mTexture->getWidth(), mTexture->getHeight(), mTexture->getWidth() * 4, ESurfaceChannels::RGBA);
     }
 
 
-    void VideoPixelFormatYUV420P16Handler::update(Frame& frame)
+    void VideoPixelFormatPacked422Handler::update(Frame& frame)
     {
         // Copy data into texture
-        assert(mYTexture != nullptr);
-        mYTexture->update(frame.mFrame->data[0], mYTexture->getWidth(), mYTexture->getHeight(), frame.mFrame->linesize[0], ESurfaceChannels::R);
-        mUTexture->update(frame.mFrame->data[1], mUTexture->getWidth(), mUTexture->getHeight(), frame.mFrame->linesize[1], ESurfaceChannels::R);
-        mVTexture->update(frame.mFrame->data[2], mVTexture->getWidth(), mVTexture->getHeight(), frame.mFrame->linesize[2], ESurfaceChannels::R);
+        assert(mTexture != nullptr);
+        mTexture->update(frame.mFrame->data[0], mTexture->getWidth(), mTexture->getHeight(), frame.mFrame->linesize[0], ESurfaceChannels::RGBA);
+    }
+
+
+    int VideoPixelFormatPacked422Handler::getPlaneTextures(std::array<Texture2D*, 4>& outTextures)
+    {
+        outTextures[0] = mTexture.get();
+        return 1;
     }
 
 
-    Material* VideoPixelFormatYUV420P16Handler::getOrCreateMaterial(utility::ErrorState& errorState)
+    Material* VideoPixelFormatPacked422Handler::getOrCreateMaterial(utility::ErrorState& errorState)
     {
-        return mService.getCore().getService<RenderService>()->getOrCreateMaterial<VideoShader>(errorState);
+        return mService.getCore().getService<RenderService>()->getOrCreateMaterial<VideoPacked422Shader>(errorState);
     }
 
     //////////////////////////////////////////////////////////////////////////
     //// Utility
     //////////////////////////////////////////////////////////////////////////
 
+    /**
+     * Pixel format handler table entry
+     */
+    struct PixelFormatHandlerEntry
+    {
+        int mPixelFormat;                                                                           ///< AVPixelFormat
+        rtti::TypeInfo (*mGetType)();                                                               ///< Returns the handler type
+        std::unique_ptr<VideoPixelFormatHandlerBase> (*mCreate)(VideoAdvancedService&, int);       ///< Creates the handler
+    };
+
+
+    template<typename T>
+    static rtti::TypeInfo getHandlerType()
+    {
+        return RTTI_OF(T);
+    }
+
+
+    template<typename T>
+    static std::unique_ptr<VideoPixelFormatHandlerBase> createHandler(VideoAdvancedService& service, int pixelFormat)
+    {
+        return std::make_unique<T>(service, pixelFormat);
+    }
+
+
+    template<typename T>
+    static constexpr PixelFormatHandlerEntry handlerEntry(int pixelFormat)
+    {
+        return { pixelFormat, &getHandlerType<T>, &createHandler<T> };
+    }
+
+
+    // All supported pixel formats and the handler that uploads them, the factory functions are driven by this table
+    static const PixelFormatHandlerEntry sPixelFormatHandlers[] =
+    {
+        handlerEntry<VideoPixelFormatYUV420P8Handler>(AV_PIX_FMT_YUV420P),
+        handlerEntry<VideoPixelFormatYUV420P8Handler>(AV_PIX_FMT_YUVJ420P),
+        handlerEntry<VideoPixelFormatYUV422P8Handler>(AV_PIX_FMT_YUV422P),
+        handlerEntry<VideoPixelFormatYUV422P8Handler>(AV_PIX_FMT_YUVJ422P),
+        handlerEntry<VideoPixelFormatYUV444P8Handler>(AV_PIX_FMT_YUV444P),
+        handlerEntry<VideoPixelFormatYUV444P8Handler>(AV_PIX_FMT_YUVJ444P),
+        handlerEntry<VideoPixelFormatYUV420P10Handler>(AV_PIX_FMT_YUV420P10LE),
+        handlerEntry<VideoPixelFormatYUV422P10Handler>(AV_PIX_FMT_YUV422P10LE),
+        handlerEntry<VideoPixelFormatYUV444P10Handler>(AV_PIX_FMT_YUV444P10LE),
+        handlerEntry<VideoPixelFormatYUV420P12Handler>(AV_PIX_FMT_YUV420P12LE),
+        handlerEntry<VideoPixelFormatYUV422P12Handler>(AV_PIX_FMT_YUV422P12LE),
+        handlerEntry<VideoPixelFormatYUV444P12Handler>(AV_PIX_FMT_YUV444P12LE),
+        handlerEntry<VideoPixelFormatYUV420P16Handler>(AV_PIX_FMT_YUV420P16LE),
+        handlerEntry<VideoPixelFormatYUV420P16Handler>(AV_PIX_FMT_YUV420P16BE),
+        handlerEntry<VideoPixelFormatYUV422P16Handler>(AV_PIX_FMT_YUV422P16LE),
+        handlerEntry<VideoPixelFormatYUV444P16Handler>(AV_PIX_FMT_YUV444P16LE),
+        handlerEntry<VideoPixelFormatYUV444P16Handler>(AV_PIX_FMT_YUV444P16BE),
+        handlerEntry<VideoPixelFormatYUVA420P8Handler>(AV_PIX_FMT_YUVA420P),
+        handlerEntry<VideoPixelFormatYUVA422P8Handler>(AV_PIX_FMT_YUVA422P),
+        handlerEntry<VideoPixelFormatYUVA444P8Handler>(AV_PIX_FMT_YUVA444P),
+        handlerEntry<VideoPixelFormatYUVA420P10Handler>(AV_PIX_FMT_YUVA420P10LE),
+        handlerEntry<VideoPixelFormatYUVA422P10Handler>(AV_PIX_FMT_YUVA422P10LE),
+        handlerEntry<VideoPixelFormatYUVA444P10Handler>(AV_PIX_FMT_YUVA444P10LE),
+        handlerEntry<VideoPixelFormatYUVA422P12Handler>(AV_PIX_FMT_YUVA422P12LE),
+        handlerEntry<VideoPixelFormatYUVA444P12Handler>(AV_PIX_FMT_YUVA444P12LE),
+        handlerEntry<VideoPixelFormatYUVA420P16Handler>(AV_PIX_FMT_YUVA420P16LE),
+        handlerEntry<VideoPixelFormatYUVA422P16Handler>(AV_PIX_FMT_YUVA422P16LE),
+        handlerEntry<VideoPixelFormatYUVA444P16Handler>(AV_PIX_FMT_YUVA444P16LE),
+        // Hap, Hap Q and Hap Alpha are decoded to RGB0 and RGBA by the FFmpeg Hap decoder
+        handlerEntry<VideoPixelFormatRGBAP8Handler>(AV_PIX_FMT_RGBA),
+        handlerEntry<VideoPixelFormatRGBAP8Handler>(AV_PIX_FMT_RGB0),
+        handlerEntry<VideoPixelFormatRGBAP8Handler>(AV_PIX_FMT_BGRA),
+        handlerEntry<VideoPixelFormatRGBAP8Handler>(AV_PIX_FMT_BGR0),
+        handlerEntry<VideoPixelFormatRGBAP8Handler>(AV_PIX_FMT_RGB24),
+        handlerEntry<VideoPixelFormatRGBAP8Handler>(AV_PIX_FMT_BGR24),
+        handlerEntry<VideoPixelFormatNV12Handler>(AV_PIX_FMT_NV12),
+        handlerEntry<VideoPixelFormatNV12Handler>(AV_PIX_FMT_P010LE),
+        handlerEntry<VideoPixelFormatNV12Handler>(AV_PIX_FMT_P016LE),
+        handlerEntry<VideoPixelFormatGrayHandler>(AV_PIX_FMT_GRAY8),
+        handlerEntry<VideoPixelFormatGrayHandler>(AV_PIX_FMT_GRAY10LE),
+        handlerEntry<VideoPixelFormatGrayHandler>(AV_PIX_FMT_GRAY12LE),
+        handlerEntry<VideoPixelFormatGrayHandler>(AV_PIX_FMT_GRAY16LE),
+        handlerEntry<VideoPixelFormatPacked422Handler>(AV_PIX_FMT_UYVY422),
+        handlerEntry<VideoPixelFormatPacked422Handler>(AV_PIX_FMT_YUYV422),
+        handlerEntry<VideoPixelFormatPacked422Handler>(AV_PIX_FMT_YVYU422),
+    };
+
+
+    /**
+     * @return the table entry of the given pixel format, nullptr when the pixel format is not supported
+     */
+    static const PixelFormatHandlerEntry* findPixelFormatHandler(int pixelFormat)
+    {
+        for (const auto& entry : sPixelFormatHandlers)
+        {
+            if (entry.mPixelFormat == pixelFormat)
+                return &entry;
+        }
+        return nullptr;
+    }
+
+
     namespace utility
     {
         std::unique_ptr<VideoPixelFormatHandlerBase> createVideoPixelFormatHandler(int pixelFormat, VideoAdvancedService& service, utility::ErrorState& error)
         {
-            switch (pixelFormat)
-            {
-                case AV_PIX_FMT_YUV420P:
-                case AV_PIX_FMT_YUVJ420P:
-                    return std::make_unique<VideoPixelFormatYUV420P8Handler>(service, pixelFormat);
-                case AV_PIX_FMT_YUV444P16BE:
-                case AV_PIX_FMT_YUV444P16LE:
-                    return std::make_unique<VideoPixelFormatYUV444P16Handler>(service, pixelFormat);
-                case AV_PIX_FMT_YUV420P16LE:
-                case AV_PIX_FMT_YUV420P16BE:
-                    return std::make_unique<VideoPixelFormatYUV420P16Handler>(service, pixelFormat);
-                case AV_PIX_FMT_RGBA:
-                case AV_PIX_FMT_RGB0:
-                    return std::make_unique<VideoPixelFormatRGBAP8Handler>(service, pixelFormat);
-                default:
-                    error.fail("Unsupported pixel format: %d", pixelFormat);
-                    return nullptr;
-            }
+            const auto* entry = findPixelFormatHandler(pixelFormat);
+            if (!error.check(entry != nullptr, "Unsupported pixel format: %d", pixelFormat))
+                return nullptr;
+
+            return entry->mCreate(service, pixelFormat);
         }
 
 
         bool getVideoPixelFormatHandlerType(int pixelFormat, rtti::TypeInfo& typeInfo, utility::ErrorState& errorState)
         {
-            switch (pixelFormat)
-            {
-                case AV_PIX_FMT_YUV420P:
-                case AV_PIX_FMT_YUVJ420P:
-                    typeInfo = rtti::TypeInfo::get<VideoPixelFormatYUV420P8Handler>();
-                    return true;
-                case AV_PIX_FMT_YUV444P16BE:
-                case AV_PIX_FMT_YUV444P16LE:
-                    typeInfo = rtti::TypeInfo::get<VideoPixelFormatYUV444P16Handler>();
-                    return true;
-                case AV_PIX_FMT_RGBA:
-                case AV_PIX_FMT_RGB0:
-                    typeInfo = rtti::TypeInfo::get<VideoPixelFormatRGBAP8Handler>();
-                    return true;
-                case AV_PIX_FMT_YUV420P16LE:
-                case AV_PIX_FMT_YUV420P16BE:
-                    typeInfo = rtti::TypeInfo::get<VideoPixelFormatYUV420P16Handler>();
-                    return true;
-                default:
-                    errorState.fail("Unsupported pixel format: %d", pixelFormat);
-                    return false;
-            }
-        }
+            const auto* entry = findPixelFormatHandler(pixelFormat);
+            if (!errorState.check(entry != nullptr, "Unsupported pixel format: %d", pixelFormat))
+                return false;
 
+            typeInfo = entry->mGetType();
+            return true;
+        }
     }
-}
\ No newline at end of file
+}
@@ -4,11 +4,15 @@
 #include <video.h>
 #include <texture.h>
 #include <materialinstance.h>
+#include <array>
+#include <type_traits>
+#include <vector>
 
 namespace nap
 {
     // Forward declares
     class VideoAdvancedService;
+    class VideoStagingRing;
 
     /**
      * Base class for video pixel format handlers. Video pixel format handlers are used to handle different video frame formats.
@@ -27,6 +31,11 @@ namespace nap
          */
         VideoPixelFormatHandlerBase(VideoAdvancedService& service, int pixelFormat);
 
+        /**
+         * Releases the staged frame that was not uploaded
+         */
+        virtual ~VideoPixelFormatHandlerBase();
+
         /**
          * Initializes the materials
          * @param errorState reference to the error state containing the error message on failure
@@ -54,11 +63,56 @@ namespace nap
         virtual void update(Frame& frame) = 0;
 
         /**
-         * @return the pixel format of the video frame
+         * Hands a frame that was copied to a staging buffer by the decode worker to the handler, call on the main thread.
+         * The copies to the plane textures are recorded by recordUpload(), a previously staged frame that was not recorded is released.
+         * @param ring the staging ring that holds the frame
+         * @param slot index of the slot in the ring
+         * @return if the handler takes the frame, false when the planes don't match the textures of the handler
+         */
+        bool stage(VideoStagingRing& ring, int slot);
+
+        /**
+         * Records the copies of the staged frame to the plane textures, call on the main thread outside of a render pass.
+         * Staged frames are only used after the first call, until then the textures are updated with update().
+         * @param commandBuffer the command buffer to record the copies in
+         */
+        void recordUpload(VkCommandBuffer commandBuffer);
+
+        /**
+         * Releases the staged frame that was not recorded, call before the staging ring is destroyed.
+         */
+        void discardStagedFrame();
+
+        /**
+         * @return if staged frames are uploaded, false until something records the uploads
+         */
+        bool isStagingActive() const { return mStagingActive; }
+
+        /**
+         * Marks the textures as changed, call after a frame is handed to the handler or the textures are cleared or resized.
+         */
+        void advanceFrameGeneration() { mFrameGeneration++; }
+
+        /**
+         * Returns the generation of the frame in the textures, increases every time the textures change.
+         * Renderers compare it with the generation they last converted to skip unchanged frames.
+         * @return the frame generation, starts at 1
+         */
+        uint64 getFrameGeneration() const { return mFrameGeneration; }
+
+        /**
          * @return the pixel format of the video frame
          */
         int getPixelFormat() const { return mPixelFormat; }
     protected:
+        /**
+         * Returns the textures the planes of a frame are copied to, in plane order.
+         * Handlers that have no texture per plane return 0, they are always updated with update().
+         * @param outTextures the plane textures
+         * @return number of plane textures
+         */
+        virtual int getPlaneTextures(std::array<Texture2D*, 4>& outTextures)    { return 0; }
+
         /**
          * @return the material used to render the video frame
          */
@@ -82,8 +136,17 @@ namespace nap
         UniformMat4Instance*		mProjectMatrixUniform = nullptr;				///< Projection matrix uniform in the material
         UniformMat4Instance*		mViewMatrixUniform = nullptr;					///< View matrix uniform in the material
         UniformStructInstance*		mMVPStruct = nullptr;							///< model view projection struct
+        UniformIntInstance*			mPremultiplyAlphaUniform = nullptr;				///< Selects premultiplied alpha output, nullptr when the format has no alpha
+        UniformIntInstance*			mGrayscaleOutputUniform = nullptr;				///< Selects the output channel of grayscale formats, nullptr for other formats
         glm::mat4x4					mModelMatrix;									///< Computed model matrix, used to scale plane to fit target bounds
+        uint64                      mUniformOwner = 0;                              ///< ID of the component that last wrote the uniforms, it only writes changed values
         int                         mPixelFormat;                                    ///< Pixel format of the video frame
+
+    private:
+        VideoStagingRing*           mStagingRing = nullptr;                         ///< Ring that holds the staged frame, nullptr when none is staged
+        int                         mStagedSlot = -1;                               ///< Slot of the staged frame
+        bool                        mStagingActive = false;                         ///< If uploads of staged frames are recorded
+        uint64                      mFrameGeneration = 1;                           ///< Generation of the frame in the textures
     };
 
     //////////////////////////////////////////////////////////////////////////
@@ -91,7 +154,8 @@ namespace nap
     //////////////////////////////////////////////////////////////////////////
 
     /**
-     * Video pixel format handler for RGBA pixel format.
+     * Video pixel format handler for 4 byte RGB pixel formats: RGBA, RGB0, BGRA and BGR0, swizzled in the shader.
+     * 3 byte RGB24 and BGR24 frames are expanded to 4 bytes, by the decode worker when staged, otherwise on upload.
      */
     class NAPAPI VideoPixelFormatRGBAP8Handler final : public VideoPixelFormatHandlerBase
     {
@@ -133,27 +197,43 @@ namespace nap
          * @return the material used to render the video frame
          */
         Material* getOrCreateMaterial(utility::ErrorState& errorState) override;
+
+        /**
+         * @return the RGBA texture
+         */
+        int getPlaneTextures(std::array<Texture2D*, 4>& outTextures) override;
     private:
         std::unique_ptr<Texture2D> mTexture;    ///< Texture used to render the video frame
         Sampler2DInstance* mSampler = nullptr;  ///< Sampler used to sample the texture in the material
+        std::vector<uint8> mExpandBuffer;       ///< Holds a 3 byte per pixel frame expanded to 4 bytes, when not expanded by the decode worker
     };
 
     //////////////////////////////////////////////////////////////////////////
-    //// YUV 420 8bit Pixel Format Handler
+    //// Planar YUV Pixel Format Handler
     //////////////////////////////////////////////////////////////////////////
 
     /**
-     * Video pixel format handler for YUV 8 pixel format.
+     * Video pixel format handler for planar YUV pixel formats, specialized on chroma subsampling and bit depth.
+     * Uploads the Y, U and V planes, and the alpha plane of YUVA formats, to a texture each. Samples of more than 8 bits are stored in 16 bit textures,
+     * the shader normalizes them by the real bit depth.
+     * @tparam ChromaShiftX log2 of the horizontal chroma subsampling: 1 for 420 and 422, 0 for 444
+     * @tparam ChromaShiftY log2 of the vertical chroma subsampling: 1 for 420, 0 for 422 and 444
+     * @tparam BitDepth number of significant bits per sample: 8, 10, 12 or 16
+     * @tparam Alpha if the format carries a full resolution alpha plane, uploaded to a fourth texture
      */
-    class NAPAPI VideoPixelFormatYUV420P8Handler final : public VideoPixelFormatHandlerBase
+    template<int ChromaShiftX, int ChromaShiftY, int BitDepth, bool Alpha = false>
+    class NAPAPI VideoPixelFormatYUVHandler final : public VideoPixelFormatHandlerBase
     {
         RTTI_ENABLE(VideoPixelFormatHandlerBase)
+        static_assert(BitDepth >= 8 && BitDepth <= 16, "unsupported bit depth");
     public:
+        using SampleType = std::conditional_t<(BitDepth > 8), uint16_t, uint8_t>;
+
         /**
          * Constructor
          * @param service reference to the video service
          */
-        VideoPixelFormatYUV420P8Handler(VideoAdvancedService& service, int pixelFormat);
+        VideoPixelFormatYUVHandler(VideoAdvancedService& service, int pixelFormat);
 
         /**
          * Initializes the materials
@@ -185,6 +265,11 @@ namespace nap
          * @return the material used to render the video frame
          */
         Material* getOrCreateMaterial(utility::ErrorState& errorState) override;
+
+        /**
+         * @return the Y, U and V textures, followed by the alpha texture
+         */
+        int getPlaneTextures(std::array<Texture2D*, 4>& outTextures) override;
     private:
         std::unique_ptr<Texture2D> mYTexture;   ///< Y texture used to render the video frame
         std::unique_ptr<Texture2D> mUTexture;   ///< U texture used to render the video frame
@@ -192,16 +277,46 @@ namespace nap
         Sampler2DInstance* mYSampler = nullptr; ///< Y sampler used to sample the Y texture in the material
         Sampler2DInstance* mUSampler = nullptr; ///< U sampler used to sample the U texture in the material
         Sampler2DInstance* mVSampler = nullptr; ///< V sampler used to sample the V texture in the material
+        std::unique_ptr<Texture2D> mATexture;   ///< Alpha texture, only created when the format carries alpha
+        Sampler2DInstance* mASampler = nullptr; ///< Alpha sampler used to sample the alpha texture in the material
     };
 
+    // Planar YUV handlers
+    using VideoPixelFormatYUV420P8Handler   = VideoPixelFormatYUVHandler<1, 1, 8>;
+    using VideoPixelFormatYUV422P8Handler   = VideoPixelFormatYUVHandler<1, 0, 8>;
+    using VideoPixelFormatYUV444P8Handler   = VideoPixelFormatYUVHandler<0, 0, 8>;
+    using VideoPixelFormatYUV420P10Handler  = VideoPixelFormatYUVHandler<1, 1, 10>;
+    using VideoPixelFormatYUV422P10Handler  = VideoPixelFormatYUVHandler<1, 0, 10>;
+    using VideoPixelFormatYUV444P10Handler  = VideoPixelFormatYUVHandler<0, 0, 10>;
+    using VideoPixelFormatYUV420P12Handler  = VideoPixelFormatYUVHandler<1, 1, 12>;
+    using VideoPixelFormatYUV422P12Handler  = VideoPixelFormatYUVHandler<1, 0, 12>;
+    using VideoPixelFormatYUV444P12Handler  = VideoPixelFormatYUVHandler<0, 0, 12>;
+    using VideoPixelFormatYUV420P16Handler  = VideoPixelFormatYUVHandler<1, 1, 16>;
+    using VideoPixelFormatYUV422P16Handler  = VideoPixelFormatYUVHandler<1, 0, 16>;
+    using VideoPixelFormatYUV444P16Handler  = VideoPixelFormatYUVHandler<0, 0, 16>;
+
+    // Planar YUV handlers with alpha
+    using VideoPixelFormatYUVA420P8Handler  = VideoPixelFormatYUVHandler<1, 1, 8, true>;
+    using VideoPixelFormatYUVA422P8Handler  = VideoPixelFormatYUVHandler<1, 0, 8, true>;
+    using VideoPixelFormatYUVA444P8Handler  = VideoPixelFormatYUVHandler<0, 0, 8, true>;
+    using VideoPixelFormatYUVA420P10Handler = VideoPixelFormatYUVHandler<1, 1, 10, true>;
+    using VideoPixelFormatYUVA422P10Handler = VideoPixelFormatYUVHandler<1, 0, 10, true>;
+    using VideoPixelFormatYUVA444P10Handler = VideoPixelFormatYUVHandler<0, 0, 10, true>;
+    using VideoPixelFormatYUVA422P12Handler = VideoPixelFormatYUVHandler<1, 0, 12, true>;
+    using VideoPixelFormatYUVA444P12Handler = VideoPixelFormatYUVHandler<0, 0, 12, true>;
+    using VideoPixelFormatYUVA420P16Handler = VideoPixelFormatYUVHandler<1, 1, 16, true>;
+    using VideoPixelFormatYUVA422P16Handler = VideoPixelFormatYUVHandler<1, 0, 16, true>;
+    using VideoPixelFormatYUVA444P16Handler = VideoPixelFormatYUVHandler<0, 0, 16, true>;
+
     //////////////////////////////////////////////////////////////////////////
-    //// YUV 444 16bit Pixel Format Handler
+    //// NV12 Semi-Planar Pixel Format Handler
     //////////////////////////////////////////////////////////////////////////
 
     /**
-     * Video pixel format handler for YUV 444 16bit pixel format.
+     * Video pixel format handler for semi-planar YUV 420 pixel formats: NV12 (8 bit), P010 and P016 (16 bit).
+     * Uploads the luma plane and the interleaved chroma plane as-is, the chroma texture is twice the chroma width.
      */
-    class NAPAPI VideoPixelFormatYUV444P16Handler final : public VideoPixelFormatHandlerBase
+    class NAPAPI VideoPixelFormatNV12Handler final : public VideoPixelFormatHandlerBase
     {
     RTTI_ENABLE(VideoPixelFormatHandlerBase)
     public:
@@ -209,7 +324,7 @@ namespace nap
          * Constructor
          * @param service reference to the video service
          */
-        VideoPixelFormatYUV444P16Handler(VideoAdvancedService& service, int pixelFormat);
+        VideoPixelFormatNV12Handler(VideoAdvancedService& service, int pixelFormat);
 
         /**
          * Initializes the materials
@@ -241,23 +356,29 @@ namespace nap
          * @return the material used to render the video frame
          */
         Material* getOrCreateMaterial(utility::ErrorState& errorState) override;
+
+        /**
+         * @return the Y and interleaved UV textures
+         */
+        int getPlaneTextures(std::array<Texture2D*, 4>& outTextures) override;
     private:
         std::unique_ptr<Texture2D> mYTexture;   ///< Y texture used to render the video frame
-        std::unique_ptr<Texture2D> mUTexture;   ///< U texture used to render the video frame
-        std::unique_ptr<Texture2D> mVTexture;   ///< V texture used to render the video frame
+        std::unique_ptr<Texture2D> mUVTexture;  ///< Interleaved UV texture used to render the video frame
         Sampler2DInstance* mYSampler = nullptr; ///< Y sampler used to sample the Y texture in the material
-        Sampler2DInstance* mUSampler = nullptr; ///< U sampler used to sample the U texture in the material
-        Sampler2DInstance* mVSampler = nullptr; ///< V sampler used to sample the V texture in the material
+        Sampler2DInstance* mUVSampler = nullptr;///< UV sampler used to sample the UV texture in the material
+        int mBytesPerSample = 1;                ///< Size of a single sample, 1 for NV12, 2 for P010 and P016
     };
 
     //////////////////////////////////////////////////////////////////////////
-    //// YUV 420 16bit Pixel Format Handler
+    //// Grayscale Pixel Format Handler
     //////////////////////////////////////////////////////////////////////////
 
     /**
-     * Video pixel format handler for YUV 420 16bit pixel format.
+     * Video pixel format handler for single channel grayscale pixel formats: GRAY8, GRAY10, GRAY12 and GRAY16.
+     * Uploads the plane to a single R8 or R16 texture, used for masks and depth videos.
+     * The value is replicated to RGB, or written to a single channel, see RenderVideoAdvancedComponent.
      */
-    class NAPAPI VideoPixelFormatYUV420P16Handler final : public VideoPixelFormatHandlerBase
+    class NAPAPI VideoPixelFormatGrayHandler final : public VideoPixelFormatHandlerBase
     {
     RTTI_ENABLE(VideoPixelFormatHandlerBase)
     public:
@@ -265,7 +386,7 @@ namespace nap
          * Constructor
          * @param service reference to the video service
          */
-        VideoPixelFormatYUV420P16Handler(VideoAdvancedService& service, int pixelFormat);
+        VideoPixelFormatGrayHandler(VideoAdvancedService& service, int pixelFormat);
 
         /**
          * Initializes the materials
@@ -297,13 +418,74 @@ namespace nap
          * @return the material used to render the video frame
          */
         Material* getOrCreateMaterial(utility::ErrorState& errorState) override;
+
+        /**
+         * @return the grayscale texture
+         */
+        int getPlaneTextures(std::array<Texture2D*, 4>& outTextures) override;
     private:
-        std::unique_ptr<Texture2D> mYTexture;   ///< Y texture used to render the video frame
-        std::unique_ptr<Texture2D> mUTexture;   ///< U texture used to render the video frame
-        std::unique_ptr<Texture2D> mVTexture;   ///< V texture used to render the video frame
-        Sampler2DInstance* mYSampler = nullptr; ///< Y sampler used to sample the Y texture in the material
-        Sampler2DInstance* mUSampler = nullptr; ///< U sampler used to sample the U texture in the material
-        Sampler2DInstance* mVSampler = nullptr; ///< V sampler used to sample the V texture in the material
+        std::unique_ptr<Texture2D> mTexture;    ///< Grayscale texture used to render the video frame
+        Sampler2DInstance* mSampler = nullptr;  ///< Sampler used to sample the texture in the material
+        int mBitDepth = 8;                      ///< Number of significant bits per sample
+    };
+
+    //////////////////////////////////////////////////////////////////////////
+    //// Packed 4:2:2 Pixel Format Handler
+    //////////////////////////////////////////////////////////////////////////
+
+    /**
+     * Video pixel format handler for packed 4:2:2 YUV pixel formats: UYVY, YUYV and YVYU.
+     * Uploads the packed plane untouched to an RGBA8 texture of half the frame width, the shader unpacks it.
+     */
+    class NAPAPI VideoPixelFormatPacked422Handler final : public VideoPixelFormatHandlerBase
+    {
+    RTTI_ENABLE(VideoPixelFormatHandlerBase)
+    public:
+        /**
+         * Constructor
+         * @param service reference to the video service
+         */
+        VideoPixelFormatPacked422Handler(VideoAdvancedService& service, int pixelFormat);
+
+        /**
+         * Initializes the materials
+         * @param errorState reference to the error state containing the error message on failure
+         * @return true if the materials were initialized correctly
+         */
+        bool init(utility::ErrorState& errorState) override;
+
+        /**
+         * Initializes the textures, called by the video player, can be called multiple times
+         * @param size the size of the textures
+         * @param errorState reference to the error state containing the error message on failure
+         * @return true if the textures were initialized correctly
+         */
+        bool initTextures(const glm::vec2& size, utility::ErrorState& errorState) override;
+
+        /**
+         * Clears the textures
+         */
+        void clearTextures() override;
+
+        /**
+         * Updates the textures with the new video frame
+         * @param frame the video frame to update
+         */
+        void update(Frame& frame) override;
+    protected:
+        /**
+         * @return the material used to render the video frame
+         */
+        Material* getOrCreateMaterial(utility::ErrorState& errorState) override;
+
+        /**
+         * @return the packed texture
+         */
+        int getPlaneTextures(std::array<Texture2D*, 4>& outTextures) override;
+    private:
+        std::unique_ptr<Texture2D> mTexture;    ///< Packed texture used to render the video frame, two pixels per texel
+        Sampler2DInstance* mSampler = nullptr;  ///< Sampler used to sample the texture in the material
+        int mPackedLayout = 0;                  ///< Byte order of the texels, UYVY (0), YUYV (1) or YVYU (2)
     };
 
     namespace utility
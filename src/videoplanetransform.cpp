@@ -0,0 +1,520 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// Local Includes
+#include "videoplanetransform.h"
+
+// External Includes
+#include <nap/assert.h>
+#include <algorithm>
+#include <vector>
+
+extern "C"
+{
+#include <libavutil/frame.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define NAP_VIDEO_PLANE_X86
+    #include <tmmintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define NAP_VIDEO_PLANE_NEON
+    #include <arm_neon.h>
+#endif
+
+// Compiles a function for an instruction set that is not enabled for the whole module, MSVC accepts the intrinsics as-is
+#if defined(NAP_VIDEO_PLANE_X86) && !defined(_MSC_VER)
+    #define NAP_VIDEO_PLANE_TARGET(isa) __attribute__((target(isa)))
+#else
+    #define NAP_VIDEO_PLANE_TARGET(isa)
+#endif
+
+namespace nap
+{
+    namespace utility
+    {
+        using ExpandRowFunction = void (*)(const uint8* src, uint8* dst, int width);
+        using SwapRowFunction = void (*)(const uint8* src, uint8* dst, int count);
+        using DitherRowFunction = void (*)(const uint8* src, uint8* dst, int count, int shift, const uint16* dither, bool bigEndian);
+        using InterleaveRowFunction = void (*)(const uint8* first, const uint8* second, uint8* dst, int count);
+
+        // 8x8 ordered dither matrix, thresholds 0 to 63
+        static constexpr uint8 sBayerMatrix[8][8] =
+        {
+            {  0, 32,  8, 40,  2, 34, 10, 42 },
+            { 48, 16, 56, 24, 50, 18, 58, 26 },
+            { 12, 44,  4, 36, 14, 46,  6, 38 },
+            { 60, 28, 52, 20, 62, 30, 54, 22 },
+            {  3, 35, 11, 43,  1, 33,  9, 41 },
+            { 51, 19, 59, 27, 49, 17, 57, 25 },
+            { 15, 47,  7, 39, 13, 45,  5, 37 },
+            { 63, 31, 55, 23, 61, 29, 53, 21 }
+        };
+
+        //////////////////////////////////////////////////////////////////////////
+        // Kernels
+        //////////////////////////////////////////////////////////////////////////
+
+        static void expandRGB24RowScalar(const uint8* src, uint8* dst, int width)
+        {
+            for (int i = 0; i < width; i++, src += 3, dst += 4)
+            {
+                dst[0] = src[0];
+                dst[1] = src[1];
+                dst[2] = src[2];
+                dst[3] = 0xff;
+            }
+        }
+
+
+        static void swapBytes16RowScalar(const uint8* src, uint8* dst, int count)
+        {
+            for (int i = 0; i < count; i++, src += 2, dst += 2)
+            {
+                uint8 first = src[0];
+                dst[0] = src[1];
+                dst[1] = first;
+            }
+        }
+
+
+        static void ditherTo8BitRowScalar(const uint8* src, uint8* dst, int count, int shift, const uint16* dither, bool bigEndian)
+        {
+            for (int i = 0; i < count; i++, src += 2)
+            {
+                int sample = bigEndian ? (src[0] << 8) | src[1] : src[0] | (src[1] << 8);
+                int value = std::min(sample + dither[i & 7], 0xffff) >> shift;
+                dst[i] = static_cast<uint8>(std::min(value, 0xff));
+            }
+        }
+
+
+        static void interleaveRowScalar(const uint8* first, const uint8* second, uint8* dst, int count)
+        {
+            for (int i = 0; i < count; i++, dst += 2)
+            {
+                dst[0] = first[i];
+                dst[1] = second[i];
+            }
+        }
+
+
+#ifdef NAP_VIDEO_PLANE_X86
+        NAP_VIDEO_PLANE_TARGET("ssse3")
+        static void expandRGB24RowSSSE3(const uint8* src, uint8* dst, int width)
+        {
+            // Spreads 4 packed pixels over 16 bytes, the alpha bytes are set afterwards
+            const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+            const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xff000000));
+
+            // 16 pixels: 48 bytes in, 64 bytes out
+            int i = 0;
+            for (; i + 16 <= width; i += 16, src += 48, dst += 64)
+            {
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+                __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+
+                __m128i p0 = _mm_shuffle_epi8(a, shuffle);
+                __m128i p1 = _mm_shuffle_epi8(_mm_alignr_epi8(b, a, 12), shuffle);
+                __m128i p2 = _mm_shuffle_epi8(_mm_alignr_epi8(c, b, 8), shuffle);
+                __m128i p3 = _mm_shuffle_epi8(_mm_srli_si128(c, 4), shuffle);
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_or_si128(p0, alpha));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16), _mm_or_si128(p1, alpha));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 32), _mm_or_si128(p2, alpha));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 48), _mm_or_si128(p3, alpha));
+            }
+            expandRGB24RowScalar(src, dst, width - i);
+        }
+
+
+        NAP_VIDEO_PLANE_TARGET("sse2")
+        static inline __m128i swapBytes16SSE2(__m128i value)
+        {
+            return _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+        }
+
+
+        NAP_VIDEO_PLANE_TARGET("sse2")
+        static void swapBytes16RowSSE2(const uint8* src, uint8* dst, int count)
+        {
+            // 8 samples per iteration
+            int i = 0;
+            for (; i + 8 <= count; i += 8, src += 16, dst += 16)
+            {
+                __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), swapBytes16SSE2(value));
+            }
+            swapBytes16RowScalar(src, dst, count - i);
+        }
+
+
+        NAP_VIDEO_PLANE_TARGET("sse2")
+        static void ditherTo8BitRowSSE2(const uint8* src, uint8* dst, int count, int shift, const uint16* dither, bool bigEndian)
+        {
+            // The dither pattern repeats every 8 samples, saturate before the shift and pack to bytes with saturation
+            const __m128i threshold = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dither));
+            const __m128i count_shift = _mm_cvtsi32_si128(shift);
+            int i = 0;
+            for (; i + 16 <= count; i += 16, src += 32)
+            {
+                __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+                __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+                if (bigEndian)
+                {
+                    low = swapBytes16SSE2(low);
+                    high = swapBytes16SSE2(high);
+                }
+                low = _mm_srl_epi16(_mm_adds_epu16(low, threshold), count_shift);
+                high = _mm_srl_epi16(_mm_adds_epu16(high, threshold), count_shift);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(low, high));
+            }
+            ditherTo8BitRowScalar(src, dst + i, count - i, shift, dither, bigEndian);
+        }
+
+
+        NAP_VIDEO_PLANE_TARGET("sse2")
+        static void interleaveRowSSE2(const uint8* first, const uint8* second, uint8* dst, int count)
+        {
+            // 16 pairs per iteration
+            int i = 0;
+            for (; i + 16 <= count; i += 16, dst += 32)
+            {
+                __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + i));
+                __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(second + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi8(a, b));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16), _mm_unpackhi_epi8(a, b));
+            }
+            interleaveRowScalar(first + i, second + i, dst, count - i);
+        }
+
+
+        static bool hasSSE2()
+        {
+#ifdef _MSC_VER
+            int info[4];
+            __cpuid(info, 1);
+            return (info[3] & (1 << 26)) != 0;
+#else
+            return __builtin_cpu_supports("sse2");
+#endif
+        }
+
+
+        static bool hasSSSE3()
+        {
+#ifdef _MSC_VER
+            int info[4];
+            __cpuid(info, 1);
+            return (info[2] & (1 << 9)) != 0;
+#else
+            return __builtin_cpu_supports("ssse3");
+#endif
+        }
+#endif // NAP_VIDEO_PLANE_X86
+
+
+#ifdef NAP_VIDEO_PLANE_NEON
+        static void expandRGB24RowNEON(const uint8* src, uint8* dst, int width)
+        {
+            // De-interleave 16 pixels and interleave them again with alpha
+            int i = 0;
+            for (; i + 16 <= width; i += 16, src += 48, dst += 64)
+            {
+                uint8x16x3_t rgb = vld3q_u8(src);
+                uint8x16x4_t rgba;
+                rgba.val[0] = rgb.val[0];
+                rgba.val[1] = rgb.val[1];
+                rgba.val[2] = rgb.val[2];
+                rgba.val[3] = vdupq_n_u8(0xff);
+                vst4q_u8(dst, rgba);
+            }
+            expandRGB24RowScalar(src, dst, width - i);
+        }
+
+
+        static void swapBytes16RowNEON(const uint8* src, uint8* dst, int count)
+        {
+            // 8 samples per iteration
+            int i = 0;
+            for (; i + 8 <= count; i += 8, src += 16, dst += 16)
+                vst1q_u8(dst, vrev16q_u8(vld1q_u8(src)));
+            swapBytes16RowScalar(src, dst, count - i);
+        }
+
+
+        static void ditherTo8BitRowNEON(const uint8* src, uint8* dst, int count, int shift, const uint16* dither, bool bigEndian)
+        {
+            // The dither pattern repeats every 8 samples, saturate before the shift and narrow to bytes with saturation
+            const uint16x8_t threshold = vld1q_u16(dither);
+            const int16x8_t count_shift = vdupq_n_s16(static_cast<int16_t>(-shift));
+            int i = 0;
+            for (; i + 16 <= count; i += 16, src += 32)
+            {
+                uint8x16_t low_bytes = vld1q_u8(src);
+                uint8x16_t high_bytes = vld1q_u8(src + 16);
+                if (bigEndian)
+                {
+                    low_bytes = vrev16q_u8(low_bytes);
+                    high_bytes = vrev16q_u8(high_bytes);
+                }
+                uint16x8_t low = vshlq_u16(vqaddq_u16(vreinterpretq_u16_u8(low_bytes), threshold), count_shift);
+                uint16x8_t high = vshlq_u16(vqaddq_u16(vreinterpretq_u16_u8(high_bytes), threshold), count_shift);
+                vst1q_u8(dst + i, vcombine_u8(vqmovn_u16(low), vqmovn_u16(high)));
+            }
+            ditherTo8BitRowScalar(src, dst + i, count - i, shift, dither, bigEndian);
+        }
+
+
+        static void interleaveRowNEON(const uint8* first, const uint8* second, uint8* dst, int count)
+        {
+            // 16 pairs per iteration
+            int i = 0;
+            for (; i + 16 <= count; i += 16, dst += 32)
+            {
+                uint8x16x2_t pairs;
+                pairs.val[0] = vld1q_u8(first + i);
+                pairs.val[1] = vld1q_u8(second + i);
+                vst2q_u8(dst, pairs);
+            }
+            interleaveRowScalar(first + i, second + i, dst, count - i);
+        }
+#endif // NAP_VIDEO_PLANE_NEON
+
+
+        //////////////////////////////////////////////////////////////////////////
+        // Dispatch
+        //////////////////////////////////////////////////////////////////////////
+
+        static ExpandRowFunction selectExpandRGB24Row()
+        {
+#if defined(NAP_VIDEO_PLANE_X86)
+            if (hasSSSE3())
+                return &expandRGB24RowSSSE3;
+#elif defined(NAP_VIDEO_PLANE_NEON)
+            return &expandRGB24RowNEON;
+#endif
+            return &expandRGB24RowScalar;
+        }
+
+
+        static SwapRowFunction selectSwapBytes16Row()
+        {
+#if defined(NAP_VIDEO_PLANE_X86)
+            if (hasSSE2())
+                return &swapBytes16RowSSE2;
+#elif defined(NAP_VIDEO_PLANE_NEON)
+            return &swapBytes16RowNEON;
+#endif
+            return &swapBytes16RowScalar;
+        }
+
+
+        static DitherRowFunction selectDitherTo8BitRow()
+        {
+#if defined(NAP_VIDEO_PLANE_X86)
+            if (hasSSE2())
+                return &ditherTo8BitRowSSE2;
+#elif defined(NAP_VIDEO_PLANE_NEON)
+            return &ditherTo8BitRowNEON;
+#endif
+            return &ditherTo8BitRowScalar;
+        }
+
+
+        static InterleaveRowFunction selectInterleaveRow()
+        {
+#if defined(NAP_VIDEO_PLANE_X86)
+            if (hasSSE2())
+                return &interleaveRowSSE2;
+#elif defined(NAP_VIDEO_PLANE_NEON)
+            return &interleaveRowNEON;
+#endif
+            return &interleaveRowScalar;
+        }
+
+
+        void expandRGB24Plane(const uint8* src, int srcStride, uint8* dst, int dstStride, int width, int height)
+        {
+            // Selected once, thread safe
+            static const ExpandRowFunction expand_row = selectExpandRGB24Row();
+            for (int row = 0; row < height; row++)
+                expand_row(src + static_cast<size_t>(row) * srcStride, dst + static_cast<size_t>(row) * dstStride, width);
+        }
+
+
+        void swapBytes16Plane(const uint8* src, int srcStride, uint8* dst, int dstStride, int count, int height)
+        {
+            static const SwapRowFunction swap_row = selectSwapBytes16Row();
+            for (int row = 0; row < height; row++)
+                swap_row(src + static_cast<size_t>(row) * srcStride, dst + static_cast<size_t>(row) * dstStride, count);
+        }
+
+
+        void ditherTo8BitPlane(const uint8* src, int srcStride, uint8* dst, int dstStride, int count, int height, int bits, bool bigEndian)
+        {
+            static const DitherRowFunction dither_row = selectDitherTo8BitRow();
+            assert(bits > 8 && bits <= 16);
+
+            // Thresholds cover one step of the reduced sample
+            int shift = bits - 8;
+            for (int row = 0; row < height; row++)
+            {
+                uint16 dither[8];
+                for (int i = 0; i < 8; i++)
+                    dither[i] = static_cast<uint16>((sBayerMatrix[row & 7][i] << shift) >> 6);
+
+                dither_row(src + static_cast<size_t>(row) * srcStride, dst + static_cast<size_t>(row) * dstStride, count, shift, dither, bigEndian);
+            }
+        }
+
+
+        void interleavePlanes(const uint8* first, int firstStride, const uint8* second, int secondStride, uint8* dst, int dstStride, int count, int height)
+        {
+            static const InterleaveRowFunction interleave_row = selectInterleaveRow();
+            for (int row = 0; row < height; row++)
+            {
+                interleave_row(first + static_cast<size_t>(row) * firstStride, second + static_cast<size_t>(row) * secondStride,
+                    dst + static_cast<size_t>(row) * dstStride, count);
+            }
+        }
+
+
+        //////////////////////////////////////////////////////////////////////////
+        // Frames
+        //////////////////////////////////////////////////////////////////////////
+
+        static bool interleaveVideoFrame(const AVFrame& src, const AVPixFmtDescriptor& descriptor, const int rowBytes[4], uint8* const dstData[4], const int dstLinesize[4])
+        {
+            if (descriptor.log2_chroma_w != 1 || descriptor.log2_chroma_h != 1)
+                return false;
+
+            int chroma_rows = AV_CEIL_RSHIFT(src.height, 1);
+            if (descriptor.comp[0].depth <= 8)
+            {
+                av_image_copy_plane(dstData[0], dstLinesize[0], src.data[0], src.linesize[0], rowBytes[0], src.height);
+                interleavePlanes(src.data[1], src.linesize[1], src.data[2], src.linesize[2], dstData[1], dstLinesize[1], rowBytes[1], chroma_rows);
+                return true;
+            }
+
+            // Wide samples are reduced first, the chroma planes through scratch memory of this thread
+            int bits = descriptor.comp[0].depth + descriptor.comp[0].shift;
+            bool big_endian = (descriptor.flags & AV_PIX_FMT_FLAG_BE) != 0;
+            int chroma_count = rowBytes[1] / 2;
+            ditherTo8BitPlane(src.data[0], src.linesize[0], dstData[0], dstLinesize[0], rowBytes[0] / 2, src.height, bits, big_endian);
+
+            thread_local std::vector<uint8> scratch;
+            size_t chroma_size = static_cast<size_t>(chroma_count) * chroma_rows;
+            scratch.resize(chroma_size * 2);
+            ditherTo8BitPlane(src.data[1], src.linesize[1], scratch.data(), chroma_count, chroma_count, chroma_rows, bits, big_endian);
+            ditherTo8BitPlane(src.data[2], src.linesize[2], scratch.data() + chroma_size, chroma_count, chroma_count, chroma_rows, bits, big_endian);
+            interleavePlanes(scratch.data(), chroma_count, scratch.data() + chroma_size, chroma_count, dstData[1], dstLinesize[1], chroma_count, chroma_rows);
+            return true;
+        }
+
+
+        int getVideoTransformFormat(int pixelFormat, bool reduceBitDepth, bool interleaveChroma)
+        {
+            // 3 byte pixels can't be copied to a texture
+            if (pixelFormat == AV_PIX_FMT_RGB24)
+                return AV_PIX_FMT_RGB0;
+            if (pixelFormat == AV_PIX_FMT_BGR24)
+                return AV_PIX_FMT_BGR0;
+
+            const AVPixFmtDescriptor* descriptor = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(pixelFormat));
+            if (descriptor == nullptr || (descriptor->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BITSTREAM | AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_PAL)) != 0)
+                return pixelFormat;
+
+            // Planar 4:2:0 chroma in a single plane
+            bool alpha = (descriptor->flags & AV_PIX_FMT_FLAG_ALPHA) != 0;
+            bool planar_420 = descriptor->nb_components == 3 && descriptor->comp[1].plane != descriptor->comp[2].plane &&
+                descriptor->log2_chroma_w == 1 && descriptor->log2_chroma_h == 1;
+            if (interleaveChroma && planar_420 && (descriptor->comp[0].depth == 8 || reduceBitDepth))
+                return AV_PIX_FMT_NV12;
+
+            // The 8 bit equivalent of gray, semi-planar 420 and planar 420, 422 and 444 formats
+            if (reduceBitDepth && descriptor->comp[0].depth > 8)
+            {
+                if (descriptor->nb_components == 1)
+                    return AV_PIX_FMT_GRAY8;
+
+                bool semi_planar = descriptor->nb_components >= 3 && descriptor->comp[1].plane == descriptor->comp[2].plane;
+                if (semi_planar && descriptor->log2_chroma_w == 1 && descriptor->log2_chroma_h == 1)
+                    return AV_PIX_FMT_NV12;
+
+                if (!semi_planar && descriptor->log2_chroma_w <= 1 && descriptor->log2_chroma_h <= descriptor->log2_chroma_w)
+                {
+                    static const AVPixelFormat sYUVFormats[] = { AV_PIX_FMT_YUV420P, AV_PIX_FMT_YUV422P, AV_PIX_FMT_YUV444P };
+                    static const AVPixelFormat sYUVAFormats[] = { AV_PIX_FMT_YUVA420P, AV_PIX_FMT_YUVA422P, AV_PIX_FMT_YUVA444P };
+                    int layout_index = descriptor->log2_chroma_w > 0 ? (descriptor->log2_chroma_h > 0 ? 0 : 1) : 2;
+                    return alpha ? sYUVAFormats[layout_index] : sYUVFormats[layout_index];
+                }
+            }
+
+            // Textures are little endian
+            if ((descriptor->flags & AV_PIX_FMT_FLAG_BE) != 0)
+            {
+                AVPixelFormat swapped = av_pix_fmt_swap_endianness(static_cast<AVPixelFormat>(pixelFormat));
+                return swapped != AV_PIX_FMT_NONE ? swapped : pixelFormat;
+            }
+            return pixelFormat;
+        }
+
+
+        bool transformVideoFrame(const AVFrame& src, int dstFormat, uint8* const dstData[4], const int dstLinesize[4])
+        {
+            auto src_format = static_cast<AVPixelFormat>(src.format);
+            const AVPixFmtDescriptor* src_descriptor = av_pix_fmt_desc_get(src_format);
+            const AVPixFmtDescriptor* dst_descriptor = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(dstFormat));
+            int plane_count = av_pix_fmt_count_planes(src_format);
+            if (src_descriptor == nullptr || dst_descriptor == nullptr || plane_count <= 0 || plane_count > 4)
+                return false;
+
+            int row_bytes[4] = { 0 };
+            if (av_image_fill_linesizes(row_bytes, src_format, src.width) < 0)
+                return false;
+
+            // Interleave planar chroma
+            if (dstFormat == AV_PIX_FMT_NV12 && plane_count == 3)
+                return interleaveVideoFrame(src, *src_descriptor, row_bytes, dstData, dstLinesize);
+
+            if (plane_count != av_pix_fmt_count_planes(static_cast<AVPixelFormat>(dstFormat)))
+                return false;
+
+            // Expand 3 byte pixels
+            if (src_format == AV_PIX_FMT_RGB24 || src_format == AV_PIX_FMT_BGR24)
+            {
+                if (dstFormat != getVideoTransformFormat(src_format, false))
+                    return false;
+
+                expandRGB24Plane(src.data[0], src.linesize[0], dstData[0], dstLinesize[0], src.width, src.height);
+                return true;
+            }
+
+            // Reduce, swap or copy every plane, the layout of the planes is the same
+            bool reduce = src_descriptor->comp[0].depth > 8 && dst_descriptor->comp[0].depth <= 8;
+            bool big_endian = (src_descriptor->flags & AV_PIX_FMT_FLAG_BE) != 0;
+            bool swap = !reduce && big_endian != ((dst_descriptor->flags & AV_PIX_FMT_FLAG_BE) != 0);
+            int bits = src_descriptor->comp[0].depth + src_descriptor->comp[0].shift;
+            for (int i = 0; i < plane_count; i++)
+            {
+                bool chroma = i == 1 || i == 2;
+                int rows = chroma ? AV_CEIL_RSHIFT(src.height, src_descriptor->log2_chroma_h) : src.height;
+                if (reduce)
+                    ditherTo8BitPlane(src.data[i], src.linesize[i], dstData[i], dstLinesize[i], row_bytes[i] / 2, rows, bits, big_endian);
+                else if (swap)
+                    swapBytes16Plane(src.data[i], src.linesize[i], dstData[i], dstLinesize[i], row_bytes[i] / 2, rows);
+                else
+                    av_image_copy_plane(dstData[i], dstLinesize[i], src.data[i], src.linesize[i], row_bytes[i], rows);
+            }
+            return true;
+        }
+    }
+}
@@ -0,0 +1,93 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+// External Includes
+#include <nap/numeric.h>
+#include <utility/dllexport.h>
+
+// Forward declares
+struct AVFrame;
+
+namespace nap
+{
+    namespace utility
+    {
+        /**
+         * Returns the pixel format a decoded frame is transformed to on the decode worker before it is uploaded:
+         * 3 byte RGB24 and BGR24 pixels are expanded to 4 bytes, big endian samples are swapped to little endian,
+         * and samples of more than 8 bits are dithered to 8 bits when reduceBitDepth is set.
+         * When interleaveChroma is set, 8 bit planar 4:2:0 frames are transformed to NV12: the chroma planes
+         * are interleaved into one plane, which is uploaded to a single texture.
+         * @param pixelFormat a pixel format supported by a pixel format handler
+         * @param reduceBitDepth if samples of more than 8 bits are reduced to 8 bits
+         * @param interleaveChroma if 8 bit planar 4:2:0 chroma is interleaved into a single plane
+         * @return the transformed pixel format, pixelFormat itself when the frame is uploaded as-is
+         */
+        int NAPAPI getVideoTransformFormat(int pixelFormat, bool reduceBitDepth, bool interleaveChroma = false);
+
+        /**
+         * Transforms all planes of a frame to the given pixel format, or copies them when the format matches.
+         * @param src the decoded frame
+         * @param dstFormat the format returned by getVideoTransformFormat() for the format of the frame
+         * @param dstData first row of every destination plane
+         * @param dstLinesize size of a destination row in bytes, for every plane
+         * @return if the transform is supported
+         */
+        bool NAPAPI transformVideoFrame(const AVFrame& src, int dstFormat, uint8* const dstData[4], const int dstLinesize[4]);
+
+        /**
+         * Expands a plane of 3 byte pixels (RGB24, BGR24) to 4 byte pixels with an opaque alpha channel, keeping the channel order.
+         * Uses the fastest kernel the CPU supports, selected at runtime: SSSE3 on x86, NEON on ARM, scalar otherwise.
+         * @param src first row of the source plane
+         * @param srcStride size of a source row in bytes, including padding
+         * @param dst first row of the destination plane, can't overlap the source
+         * @param dstStride size of a destination row in bytes, including padding
+         * @param width number of pixels in a row
+         * @param height number of rows
+         */
+        void NAPAPI expandRGB24Plane(const uint8* src, int srcStride, uint8* dst, int dstStride, int width, int height);
+
+        /**
+         * Swaps the bytes of a plane of 16 bit samples, big to little endian or the other way around.
+         * Uses the fastest kernel the CPU supports, selected at runtime: SSE2 on x86, NEON on ARM, scalar otherwise.
+         * @param src first row of the source plane
+         * @param srcStride size of a source row in bytes, including padding
+         * @param dst first row of the destination plane
+         * @param dstStride size of a destination row in bytes, including padding
+         * @param count number of samples in a row
+         * @param height number of rows
+         */
+        void NAPAPI swapBytes16Plane(const uint8* src, int srcStride, uint8* dst, int dstStride, int count, int height);
+
+        /**
+         * Reduces a plane of 16 bit samples to 8 bits with an 8x8 ordered dither, which hides the banding of plain truncation.
+         * Uses the fastest kernel the CPU supports, selected at runtime: SSE2 on x86, NEON on ARM, scalar otherwise.
+         * @param src first row of the source plane
+         * @param srcStride size of a source row in bytes, including padding
+         * @param dst first row of the destination plane
+         * @param dstStride size of a destination row in bytes, including padding
+         * @param count number of samples in a row
+         * @param height number of rows
+         * @param bits number of bits up to and including the most significant bit of a sample: 10 for yuv420p10, 16 for p010
+         * @param bigEndian if the samples are big endian
+         */
+        void NAPAPI ditherTo8BitPlane(const uint8* src, int srcStride, uint8* dst, int dstStride, int count, int height, int bits, bool bigEndian);
+
+        /**
+         * Interleaves two planes of 8 bit samples into one plane of sample pairs, the U and V planes into an NV12 chroma plane.
+         * Uses the fastest kernel the CPU supports, selected at runtime: SSE2 on x86, NEON on ARM, scalar otherwise.
+         * @param first first row of the plane that holds the first sample of every pair
+         * @param firstStride size of a row of the first plane in bytes, including padding
+         * @param second first row of the plane that holds the second sample of every pair
+         * @param secondStride size of a row of the second plane in bytes, including padding
+         * @param dst first row of the destination plane
+         * @param dstStride size of a destination row in bytes, including padding
+         * @param count number of samples in a row of a source plane
+         * @param height number of rows
+         */
+        void NAPAPI interleavePlanes(const uint8* first, int firstStride, const uint8* second, int secondStride, uint8* dst, int dstStride, int count, int height);
+    }
+}
@@ -0,0 +1,77 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+// External Includes
+#include <nap/numeric.h>
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+namespace nap
+{
+    /**
+     * Playback state of a threaded video player, published by the decode worker.
+     */
+    struct VideoPlaybackState
+    {
+        double mCurrentTime = 0.0;          ///< Current position of the decoder in seconds
+        double mDuration = 0.0;             ///< Duration of the video in seconds
+        double mLastPTS = -1.0;             ///< Presentation time stamp of the last decoded frame in seconds
+        int64 mFrameIndex = -1;             ///< Frame number of the last decoded frame, from its presentation time, -1 when unknown
+        double mSeekLatency = 0.0;          ///< Time in seconds between applying the last seek and decoding the frame it landed on
+        bool mKeyframeIndexReady = false;   ///< If seekToFrame() uses the keyframe index
+        int mPlaylistIndex = -1;            ///< Index of the playlist entry that is decoded, -1 when not playing a playlist
+        bool mPlaying = false;              ///< If the decoder is playing
+        int mConvertedPixelFormat = -1;     ///< Unsupported pixel format the worker converts from (slow path), -1 when frames are uploaded as decoded
+        double mConversionTime = 0.0;       ///< Average time in seconds the worker spends converting a frame
+    };
+
+
+    /**
+     * Single writer, multiple reader snapshot of the playback state, implemented as a sequence lock.
+     * The writer never blocks and never allocates, readers retry only when they overlap with a write.
+     */
+    class VideoPlaybackStateSnapshot final
+    {
+        static_assert(std::is_trivially_copyable<VideoPlaybackState>::value, "playback state must be trivially copyable");
+    public:
+        /**
+         * Publishes a new state, single writer only
+         * @param state the state to publish
+         */
+        void store(const VideoPlaybackState& state)
+        {
+            // An odd sequence marks a write in progress
+            uint32 sequence = mSequence.load(std::memory_order_relaxed);
+            mSequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            std::memcpy(&mState, &state, sizeof(VideoPlaybackState));
+            mSequence.store(sequence + 2, std::memory_order_release);
+        }
+
+        /**
+         * @return the last published state, thread safe
+         */
+        VideoPlaybackState load() const
+        {
+            VideoPlaybackState state;
+            uint32 begin, end;
+            do
+            {
+                begin = mSequence.load(std::memory_order_acquire);
+                std::memcpy(&state, &mState, sizeof(VideoPlaybackState));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                end = mSequence.load(std::memory_order_relaxed);
+            }
+            while ((begin & 1) != 0 || begin != end);
+            return state;
+        }
+
+    private:
+        VideoPlaybackState mState;                  ///< The published state
+        std::atomic<uint32> mSequence = { 0 };      ///< Sequence counter, odd while a write is in progress
+    };
+}
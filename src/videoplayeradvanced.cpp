@@ -31,6 +31,28 @@ RTTI_END_CLASS
 
 namespace nap
 {
+    /**
+     * Reads the pixel format and size of the video stream from the container header, without probing or decoding the stream.
+     * nap::Video doesn't expose its codec parameters, this only reads the header of the file.
+     * @return if the container declares the pixel format, it's taken from the first decoded frame otherwise
+     */
+    static bool readHeaderProbe(const std::string& path, VideoProbe& outProbe)
+    {
+        AVFormatContext* format_context = nullptr;
+        if (avformat_open_input(&format_context, path.c_str(), nullptr, nullptr) < 0)
+            return false;
+
+        int stream_index = av_find_best_stream(format_context, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+        if (stream_index >= 0)
+        {
+            const AVCodecParameters& parameters = *format_context->streams[stream_index]->codecpar;
+            outProbe.mPixelFormat = parameters.format;
+            outProbe.mWidth = parameters.width;
+            outProbe.mHeight = parameters.height;
+        }
+        avformat_close_input(&format_context);
+        return outProbe.mPixelFormat >= 0 && outProbe.mWidth > 0 && outProbe.mHeight > 0;
+    }
 
 
     VideoPlayerAdvanced::VideoPlayerAdvanced(VideoAdvancedService& service) :
@@ -108,39 +130,31 @@ namespace nap
             mCurrentVideo->stop(true);
 
         mCurrentVideo = nullptr;
-
-        auto new_video_file = std::make_unique<nap::VideoFile>();
-        new_video_file->mPath = path;
-        new_video_file->mID = math::generateUUID();
-        if(!new_video_file->init(error))
+        beginLoad();
+
+        // Set up the pixel format handler before the decoder is opened, unsupported formats fail here.
+        // The format of a known file is cached, otherwise it's read from the container header when declared there.
+        VideoProbe probe;
+        mCacheProbe = !mService.getProbeCache().find(path, probe);
+        mProbePTS = -1.0;
+        mVideoPath = path;
+        if(!mCacheProbe || readHeaderProbe(path, probe))
         {
-            error.fail("%s: Unable to load video for file: %s", mID.c_str(), path.c_str());
-            return false;
+            if(!preparePixelFormatHandler(probe.mPixelFormat, { probe.mWidth, probe.mHeight }, error))
+            {
+                error.fail("%s: Unable to load video for file: %s", mID.c_str(), path.c_str());
+                return false;
+            }
         }
 
-        auto new_video = std::make_unique<nap::Video>(new_video_file->mPath);
+        // Open and probe the file once, the pixel format handler is updated when the first frame is presented
+        auto new_video = std::make_unique<nap::Video>(path);
         if(!new_video->init(error))
         {
             error.fail("%s: Unable to load video for file: %s", mID.c_str(), path.c_str());
             return false;
         }
 
-        mPixelFormatHandler = utility::createVideoPixelFormatHandler(new_video_file->getPixelFormat(), mService, error);
-        if(mPixelFormatHandler == nullptr)
-        {
-            error.fail("%s: Unable to create pixel format handler", mID.c_str());
-            return false;
-        }
-
-        if(!mPixelFormatHandler->init(error))
-            return false;
-
-        if(!mPixelFormatHandler->initTextures({ mCurrentVideo->getWidth(), mCurrentVideo->getHeight() }, error))
-            return false;
-
-        //
-        onPixelFormatHandlerChanged(*mPixelFormatHandler);
-
         // Update selection
         mCurrentVideo = new_video.get();
 
@@ -178,7 +192,10 @@ namespace nap
     void VideoPlayerAdvanced::clearTextures()
     {
         if(hasPixelFormatHandler())
+        {
             mPixelFormatHandler->clearTextures();
+            mPixelFormatHandler->advanceFrameGeneration();
+        }
     }
 
 
@@ -254,10 +271,28 @@ namespace nap
         Frame new_frame = mCurrentVideo->update(deltaTime);
         if (new_frame.isValid())
         {
-            mPixelFormatHandler->update(new_frame);
+            utility::ErrorState error;
+            if (!presentFrame(new_frame, error))
+            {
+                nap::Logger::error("%s: %s", mID.c_str(), error.toString().c_str());
+                mCurrentVideo->stop(true);
+            }
+
+            // Cache the probe result for the next load of this file, once the frame rate is known
+            if (mCacheProbe)
+            {
+                double pts_delta = new_frame.mPTSSecs - mProbePTS;
+                if (mProbePTS >= 0.0 && pts_delta > 0.0 && pts_delta < 1.0)
+                {
+                    storeProbe(mVideoPath, *mCurrentVideo, new_frame, pts_delta);
+                    mCacheProbe = false;
+                }
+                mProbePTS = new_frame.mPTSSecs;
+            }
         }
 
-        // Destroy frame that was allocated in the decode thread, after it has been processed
+        // Free frame that was allocated in the decode thread, after it has been processed.
+        // Decoded frames are not pooled, their buffers go back to the decoder.
         new_frame.free();
     }
 }
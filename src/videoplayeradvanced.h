@@ -5,7 +5,6 @@
 #pragma once
 
 // Local Includes
-#include "videofile.h"
 #include "video.h"
 #include "videoplayeradvancedbase.h"
 
@@ -119,6 +118,8 @@ namespace nap
 
         /**
          * Load a video from a file.
+         * Fails when no pixel format handler supports the video, the pixel format is read from the probe cache
+         * or the container header. Formats the container doesn't declare are detected on the first decoded frame.
          * @param filePath path to video file
          * @param errorState contains the error if the video can't be loaded
          * @return true if the video was loaded successfully
@@ -146,6 +147,9 @@ namespace nap
 
         nap::Video* mCurrentVideo = nullptr;					///< Current selected video context
         std::unique_ptr<nap::Video> mVideo;		                ///< The actual video
+        std::string mVideoPath;									///< Path of the current video
+        bool mCacheProbe = false;								///< If the probe result of the current video still needs to be cached
+        double mProbePTS = -1.0;								///< Presentation time stamp of the previous frame, used to find the frame rate
     };
 
     // Object creator
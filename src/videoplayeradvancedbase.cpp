@@ -1,4 +1,14 @@
 #include "videoplayeradvancedbase.h"
+#include "videostagingring.h"
+#include "videoadvancedservice.h"
+
+#include <nap/logger.h>
+#include <nap/assert.h>
+
+extern "C"
+{
+#include <libavutil/frame.h>
+}
 
 RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoPlayerAdvancedBase)
         RTTI_PROPERTY("NumThreads", &nap::VideoPlayerAdvancedBase::mNumThreads, nap::rtti::EPropertyMetaData::Default, "Number of threads to use for decoding. 0 means automatic.")
@@ -6,8 +16,138 @@ RTTI_END_CLASS
 
 namespace nap
 {
+    // Weight of the last frame in the upload time average
+    static constexpr double sUploadTimeWeight = 0.05;
+
+
     VideoPlayerAdvancedBase::VideoPlayerAdvancedBase(VideoAdvancedService& service) :
             mService(service)
     { }
 
-}
\ No newline at end of file
+
+    void VideoPlayerAdvancedBase::beginLoad()
+    {
+        mLoadTimeStamp = SteadyClock::now();
+        mAwaitFirstFrame = true;
+    }
+
+
+    bool VideoPlayerAdvancedBase::presentFrame(Frame& frame, utility::ErrorState& errorState)
+    {
+        assert(frame.isValid());
+        glm::ivec2 size = { frame.mFrame->width, frame.mFrame->height };
+        if(!preparePixelFormatHandler(frame.mFrame->format, size, errorState))
+            return false;
+
+        SteadyTimeStamp upload_start = SteadyClock::now();
+        mPixelFormatHandler->update(frame);
+        mPixelFormatHandler->advanceFrameGeneration();
+        measureUpload(upload_start);
+        measureFirstFrame();
+        return true;
+    }
+
+
+    bool VideoPlayerAdvancedBase::presentFrame(Frame& frame, VideoStagingRing& stagingRing, int stagingSlot, utility::ErrorState& errorState)
+    {
+        // Not staged, upload on the main thread
+        if(stagingSlot < 0)
+            return presentFrame(frame, errorState);
+
+        assert(frame.isValid());
+        glm::ivec2 size = { frame.mFrame->width, frame.mFrame->height };
+        if(!preparePixelFormatHandler(frame.mFrame->format, size, errorState))
+        {
+            stagingRing.release(stagingSlot);
+            return false;
+        }
+
+        // Nothing records the copies or the handler can't use the staged planes, upload on the main thread.
+        // The frame refers to the staging buffer, the slot is released after the upload.
+        SteadyTimeStamp upload_start = SteadyClock::now();
+        if(!mPixelFormatHandler->isStagingActive() || !mPixelFormatHandler->stage(stagingRing, stagingSlot))
+        {
+            mPixelFormatHandler->update(frame);
+            stagingRing.release(stagingSlot);
+        }
+        mPixelFormatHandler->advanceFrameGeneration();
+        measureUpload(upload_start);
+        measureFirstFrame();
+        return true;
+    }
+
+
+    void VideoPlayerAdvancedBase::storeProbe(const std::string& path, const Video& video, const Frame& frame, double frameInterval)
+    {
+        assert(frame.isValid() && frameInterval > 0.0);
+        VideoProbe probe;
+        probe.mPixelFormat = frame.mFrame->format;
+        probe.mWidth = frame.mFrame->width;
+        probe.mHeight = frame.mFrame->height;
+        probe.mDuration = video.getDuration();
+        probe.mFrameRate = 1.0 / frameInterval;
+        probe.mHasAudio = video.hasAudio();
+        mService.getProbeCache().store(path, probe);
+    }
+
+
+    void VideoPlayerAdvancedBase::measureFirstFrame()
+    {
+        // Measure the switch to first frame time
+        if(mAwaitFirstFrame)
+        {
+            mAwaitFirstFrame = false;
+            mFirstFrameLatency = std::chrono::duration<double>(SteadyClock::now() - mLoadTimeStamp).count();
+            nap::Logger::debug("%s: first frame presented after %.2f ms", mID.c_str(), mFirstFrameLatency * 1000.0);
+        }
+    }
+
+
+    void VideoPlayerAdvancedBase::measureUpload(const SteadyTimeStamp& start)
+    {
+        double upload_time = std::chrono::duration<double>(SteadyClock::now() - start).count();
+        mUploadTime = mUploadTime > 0.0 ? mUploadTime + (upload_time - mUploadTime) * sUploadTimeWeight : upload_time;
+    }
+
+
+    bool VideoPlayerAdvancedBase::preparePixelFormatHandler(int pixelFormat, const glm::ivec2& size, utility::ErrorState& errorState)
+    {
+        // Nothing changed
+        if(mPixelFormatHandler != nullptr && pixelFormat == mHandlerPixelFormat && size == mHandlerSize)
+            return true;
+
+        // Determine if we need to create a new pixel format handler,
+        // either there is none or the current one was set up for another pixel format
+        rtti::TypeInfo handler_type = RTTI_OF(VideoPixelFormatHandlerBase);
+        if(!utility::getVideoPixelFormatHandlerType(pixelFormat, handler_type, errorState))
+            return false;
+
+        std::unique_ptr<VideoPixelFormatHandlerBase> new_handler = nullptr;
+        if(mPixelFormatHandler == nullptr || mPixelFormatHandler->get_type() != handler_type || mPixelFormatHandler->getPixelFormat() != pixelFormat)
+        {
+            new_handler = utility::createVideoPixelFormatHandler(pixelFormat, mService, errorState);
+            if(!errorState.check(new_handler != nullptr, "%s: Unable to create pixel format handler", mID.c_str()))
+                return false;
+
+            if(!errorState.check(new_handler->init(errorState), "%s: Unable to initialize pixel format handler", mID.c_str()))
+                return false;
+        }
+
+        // Initialize the textures, this will delete and create new textures if the size of the video has changed
+        auto* handler = new_handler != nullptr ? new_handler.get() : mPixelFormatHandler.get();
+        if(!errorState.check(handler->initTextures(size, errorState), "%s: Unable to initialize pixel format handler textures", mID.c_str()))
+            return false;
+        handler->advanceFrameGeneration();
+
+        mHandlerPixelFormat = pixelFormat;
+        mHandlerSize = size;
+
+        // If we created a new pixel format handler, move ownership and notify any listeners (like the render component)
+        if(new_handler != nullptr)
+        {
+            mPixelFormatHandler = std::move(new_handler);
+            onPixelFormatHandlerChanged(*mPixelFormatHandler);
+        }
+        return true;
+    }
+}
@@ -1,11 +1,15 @@
 #pragma once
 
 #include <nap/device.h>
+#include <nap/datetime.h>
 
 #include "videopixelformathandler.h"
 
 namespace nap
 {
+    // Forward declares
+    class VideoStagingRing;
+
     /**
      * Base class for advanced video players. Advanced Video players have a pixel format handler to deal with
      * different video frame formats.
@@ -29,6 +33,19 @@ namespace nap
 
         bool hasPixelFormatHandler() const { return mPixelFormatHandler != nullptr; }
 
+        /**
+         * Returns the time between the last load request and the first frame of that video being presented.
+         * @return the switch to first frame time in seconds, 0 when no video was presented yet
+         */
+        double getFirstFrameLatency() const { return mFirstFrameLatency; }
+
+        /**
+         * Returns the main thread time spent handing a frame to the pixel format handler, averaged over recent frames.
+         * Covers the texture updates of a regular upload, or only the hand over of a frame staged by the decode worker.
+         * @return the average upload time in seconds
+         */
+        double getUploadTime() const { return mUploadTime; }
+
         // Properties
         int mNumThreads = 0;	///< Property: 'NumThreads' number of threads to use for decoding. 0 means automatic.
 
@@ -41,10 +58,77 @@ namespace nap
          */
         virtual void update(double deltaTime) = 0;
 
+        /**
+         * Marks the start of a video load, the time until the first frame is presented is measured.
+         * Call on the main thread.
+         */
+        void beginLoad();
+
+        /**
+         * Uploads a decoded frame to the pixel format handler, call on the main thread.
+         * The pixel format and size are taken from the frame, the video is only opened and probed once by the decoder.
+         * The handler is created when there is none or when it doesn't support the pixel format,
+         * the textures are re-created when the frame size changes.
+         * @param frame the frame to present
+         * @param errorState contains the error if the pixel format handler can't be created
+         * @return if the frame was presented
+         */
+        bool presentFrame(Frame& frame, utility::ErrorState& errorState);
+
+        /**
+         * Presents a frame that was copied to a staging buffer by the decode worker, call on the main thread.
+         * The handler records the copies from the staging buffer when it's rendered, it falls back to a regular upload
+         * when it can't use the staged planes or nothing records the copies. The slot is always handed over or released.
+         * @param frame the frame to present, refers to the staging buffer when staged
+         * @param stagingRing the ring that holds the staged frame
+         * @param stagingSlot index of the staged frame in the ring, -1 when the frame was not staged
+         * @param errorState contains the error if the pixel format handler can't be created
+         * @return if the frame was presented
+         */
+        bool presentFrame(Frame& frame, VideoStagingRing& stagingRing, int stagingSlot, utility::ErrorState& errorState);
+
+        /**
+         * Creates the pixel format handler, or reuses the current one if it supports the pixel format.
+         * Called by presentFrame(), or ahead of decoding when the pixel format of a video is known up front.
+         * @param pixelFormat the pixel format of the video
+         * @param size the size of the video in pixels
+         * @param errorState contains the error if the handler can't be created
+         * @return if the handler is ready
+         */
+        bool preparePixelFormatHandler(int pixelFormat, const glm::ivec2& size, utility::ErrorState& errorState);
+
+        /**
+         * Caches the pixel format, size and frame rate of a video file in the probe cache of the service,
+         * for the next load of the file. Call once the frame rate is known, from the thread that decodes the video.
+         * @param path the video file
+         * @param video the video that decoded the frame
+         * @param frame a decoded frame of the video
+         * @param frameInterval time between two decoded frames in seconds
+         */
+        void storeProbe(const std::string& path, const Video& video, const Frame& frame, double frameInterval);
+
         // Reference to the video service
         VideoAdvancedService &mService;
 
         // Pixel format handler
         std::unique_ptr<VideoPixelFormatHandlerBase> mPixelFormatHandler;
+
+    private:
+        /**
+         * Measures the switch to first frame time when the first frame of a load is presented
+         */
+        void measureFirstFrame();
+
+        /**
+         * Updates the upload time average with the time since the given time stamp
+         */
+        void measureUpload(const SteadyTimeStamp& start);
+
+        int mHandlerPixelFormat = -1;                       ///< Pixel format the handler was last set up for
+        glm::ivec2 mHandlerSize = { 0, 0 };                 ///< Size the handler textures were last created for
+        SteadyTimeStamp mLoadTimeStamp;                     ///< Time the last load was requested
+        bool mAwaitFirstFrame = false;                      ///< If the first frame of the last load was not presented yet
+        double mFirstFrameLatency = 0.0;                    ///< Switch to first frame time in seconds
+        double mUploadTime = 0.0;                           ///< Average main thread upload time in seconds
     };
 }
\ No newline at end of file
@@ -0,0 +1,195 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// Local Includes
+#include "videoprobecache.h"
+
+// External Includes
+#include <utility/fileutils.h>
+#include <filesystem>
+#include <fstream>
+#include <algorithm>
+
+namespace nap
+{
+    // Cache file identification
+    static constexpr uint32 sCacheMagic = 0x5052504e;     // 'NPRP'
+    static constexpr uint32 sCacheVersion = 1;
+
+    // Longest path accepted from the cache file
+    static constexpr uint32 sMaxPathLength = 32768;
+
+    // Size of an entry without the path: path length, file stamp and probe
+    static constexpr uint64 sEntrySize = sizeof(uint32) + sizeof(uint64) + sizeof(int64) + 3 * sizeof(int) + 2 * sizeof(double) + sizeof(uint8);
+
+
+    template<typename T>
+    static void writeValue(std::ofstream& stream, const T& value)
+    {
+        stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+
+    template<typename T>
+    static bool readValue(std::ifstream& stream, T& value)
+    {
+        return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+    }
+
+
+    VideoProbeCache::VideoProbeCache(const std::string& path) :
+        mPath(path)
+    { }
+
+
+    bool VideoProbeCache::load(utility::ErrorState& errorState)
+    {
+        if (mPath.empty() || !utility::fileExists(mPath))
+            return true;
+
+        std::ifstream stream(mPath, std::ios::binary | std::ios::ate);
+        if (!errorState.check(stream.is_open(), "Unable to open probe cache: %s", mPath.c_str()))
+            return false;
+
+        auto file_size = static_cast<uint64>(stream.tellg());
+        stream.seekg(0);
+        std::unordered_map<std::string, Entry> entries;
+        if (!readEntries(stream, file_size, entries))
+        {
+            // Drop the invalid cache, it is replaced on save
+            std::lock_guard<std::mutex> lock(mMutex);
+            mEntries.clear();
+            mDirty = true;
+            errorState.fail("Invalid probe cache: %s", mPath.c_str());
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mEntries = std::move(entries);
+        mDirty = false;
+        return true;
+    }
+
+
+    bool VideoProbeCache::readEntries(std::ifstream& stream, uint64 fileSize, std::unordered_map<std::string, Entry>& outEntries)
+    {
+        // Sizes read from the file are checked against the bytes that are left, a corrupt file can't trigger huge allocations
+        auto remaining = [&stream, fileSize]()
+        {
+            auto position = stream.tellg();
+            return position < 0 ? uint64(0) : fileSize - std::min(static_cast<uint64>(position), fileSize);
+        };
+
+        uint32 magic = 0, version = 0;
+        uint64 count = 0;
+        if (!readValue(stream, magic) || !readValue(stream, version) || !readValue(stream, count) ||
+            magic != sCacheMagic || version != sCacheVersion || count > remaining() / sEntrySize)
+            return false;
+
+        // Read all entries in one go, lookups never touch the disk
+        outEntries.reserve(count);
+        for (uint64 i = 0; i < count; i++)
+        {
+            uint32 path_length = 0;
+            if (!readValue(stream, path_length) || path_length > sMaxPathLength || path_length > remaining())
+                return false;
+
+            std::string path(path_length, '\0');
+            if (!stream.read(path.data(), path_length))
+                return false;
+
+            Entry entry;
+            uint8 has_audio = 0;
+            if (!readValue(stream, entry.mStamp.mSize) || !readValue(stream, entry.mStamp.mTime) ||
+                !readValue(stream, entry.mProbe.mPixelFormat) || !readValue(stream, entry.mProbe.mWidth) || !readValue(stream, entry.mProbe.mHeight) ||
+                !readValue(stream, entry.mProbe.mDuration) || !readValue(stream, entry.mProbe.mFrameRate) || !readValue(stream, has_audio))
+                return false;
+
+            entry.mProbe.mHasAudio = has_audio != 0;
+            outEntries[path] = entry;
+        }
+        return true;
+    }
+
+
+    bool VideoProbeCache::save(utility::ErrorState& errorState)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mPath.empty() || !mDirty)
+            return true;
+
+        // Write to a temporary file first, a crash never leaves a partial cache behind
+        std::string temp_path = mPath + ".tmp";
+        {
+            std::ofstream stream(temp_path, std::ios::binary | std::ios::trunc);
+            if (!errorState.check(stream.is_open(), "Unable to write probe cache: %s", mPath.c_str()))
+                return false;
+
+            writeValue(stream, sCacheMagic);
+            writeValue(stream, sCacheVersion);
+            writeValue(stream, static_cast<uint64>(mEntries.size()));
+            for (const auto& it : mEntries)
+            {
+                const auto& entry = it.second;
+                writeValue(stream, static_cast<uint32>(it.first.size()));
+                stream.write(it.first.data(), it.first.size());
+                writeValue(stream, entry.mStamp.mSize);
+                writeValue(stream, entry.mStamp.mTime);
+                writeValue(stream, entry.mProbe.mPixelFormat);
+                writeValue(stream, entry.mProbe.mWidth);
+                writeValue(stream, entry.mProbe.mHeight);
+                writeValue(stream, entry.mProbe.mDuration);
+                writeValue(stream, entry.mProbe.mFrameRate);
+                writeValue(stream, static_cast<uint8>(entry.mProbe.mHasAudio ? 1 : 0));
+            }
+
+            if (!errorState.check(static_cast<bool>(stream), "Unable to write probe cache: %s", mPath.c_str()))
+                return false;
+        }
+
+        std::error_code error;
+        std::filesystem::rename(temp_path, mPath, error);
+        if (!errorState.check(!error, "Unable to write probe cache: %s", mPath.c_str()))
+            return false;
+
+        mDirty = false;
+        return true;
+    }
+
+
+    bool VideoProbeCache::find(const std::string& videoPath, VideoProbe& outProbe)
+    {
+        // Read the file stamp outside of the lock
+        VideoFileStamp stamp;
+        if (!VideoFileStamp::read(videoPath, stamp))
+        {
+            mMisses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mEntries.find(videoPath);
+        if (it == mEntries.end() || it->second.mStamp != stamp)
+        {
+            mMisses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        outProbe = it->second.mProbe;
+        mHits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+
+    void VideoProbeCache::store(const std::string& videoPath, const VideoProbe& probe)
+    {
+        VideoFileStamp stamp;
+        if (!VideoFileStamp::read(videoPath, stamp))
+            return;
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        mEntries[videoPath] = { stamp, probe };
+        mDirty = true;
+    }
+}
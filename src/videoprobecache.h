@@ -0,0 +1,111 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+// Local Includes
+#include "videofilestamp.h"
+
+// External Includes
+#include <nap/numeric.h>
+#include <utility/errorstate.h>
+#include <atomic>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace nap
+{
+    /**
+     * Stream information of a video file, as found by opening and decoding it.
+     */
+    struct VideoProbe
+    {
+        int mPixelFormat = -1;              ///< Pixel format of the decoded frames
+        int mWidth = 0;                     ///< Width of the decoded frames in pixels
+        int mHeight = 0;                    ///< Height of the decoded frames in pixels
+        double mDuration = 0.0;             ///< Duration of the video in seconds
+        double mFrameRate = 0.0;            ///< Frame rate of the video stream
+        bool mHasAudio = false;             ///< If the video has an audio stream
+    };
+
+
+    /**
+     * Service wide cache of video probe results, keyed by path, size and modification time of the video file.
+     * Allows a player to set up the pixel format handler for a known file before the decoder is opened.
+     * The cache is loaded from disk once and written back on shutdown, entries of modified files are ignored.
+     * All functions are thread safe.
+     */
+    class NAPAPI VideoProbeCache final
+    {
+    public:
+        /**
+         * @param path path to the cache file, when empty the cache is not persisted
+         */
+        VideoProbeCache(const std::string& path);
+
+        /**
+         * Loads all entries from the cache file, a missing cache file is not an error.
+         * @param errorState contains the error if the cache file is invalid
+         * @return if the cache file was loaded or does not exist
+         */
+        bool load(utility::ErrorState& errorState);
+
+        /**
+         * Writes all entries to the cache file, only when entries were added since the last load or save.
+         * @param errorState contains the error if the cache file can't be written
+         * @return if the cache file was written or up to date
+         */
+        bool save(utility::ErrorState& errorState);
+
+        /**
+         * Finds the probe result of a video file, fails when the file changed since it was probed.
+         * @param videoPath path to the video file
+         * @param outProbe the probe result
+         * @return if an up to date probe result was found
+         */
+        bool find(const std::string& videoPath, VideoProbe& outProbe);
+
+        /**
+         * Stores the probe result of a video file, replaces the existing entry.
+         * @param videoPath path to the video file
+         * @param probe the probe result
+         */
+        void store(const std::string& videoPath, const VideoProbe& probe);
+
+        /**
+         * @return number of lookups that found an up to date probe result
+         */
+        uint64 getHits() const                      { return mHits.load(std::memory_order_relaxed); }
+
+        /**
+         * @return number of lookups that did not find an up to date probe result
+         */
+        uint64 getMisses() const                    { return mMisses.load(std::memory_order_relaxed); }
+
+    private:
+        struct Entry
+        {
+            VideoFileStamp mStamp;                  ///< Stamp of the file when it was probed
+            VideoProbe mProbe;                      ///< The probe result
+        };
+
+        /**
+         * Reads and validates all entries of the cache file
+         * @param stream the cache file, positioned at the start
+         * @param fileSize size of the cache file in bytes
+         * @param outEntries the entries read from the file
+         * @return if the file is a valid cache
+         */
+        bool readEntries(std::ifstream& stream, uint64 fileSize, std::unordered_map<std::string, Entry>& outEntries);
+
+        std::string mPath;                                      ///< Path to the cache file
+        std::unordered_map<std::string, Entry> mEntries;        ///< All entries by video path
+        bool mDirty = false;                                    ///< If entries were added since the last load or save
+        std::mutex mMutex;                                      ///< Guards the entries
+        std::atomic<uint64> mHits = { 0 };                      ///< Number of lookups that found a result
+        std::atomic<uint64> mMisses = { 0 };                    ///< Number of lookups that did not find a result
+    };
+}
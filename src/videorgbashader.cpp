@@ -4,11 +4,6 @@
 
 // Local includes
 #include "videorgbashader.h"
-#include "renderservice.h"
-#include "videoadvancedservice.h"
-
-// External includes
-#include <nap/core.h>
 
 // nap::VideoShader run time class definition 
 RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoRGBAShader)
@@ -28,42 +23,6 @@ namespace nap
 	}
 
 
-	VideoRGBAShader::VideoRGBAShader(Core& core) : Shader(core),
-		mRenderService(core.getService<RenderService>())
+	VideoRGBAShader::VideoRGBAShader(Core& core) : VideoAdvancedShader(core, shader::videorgba, shader::videorgba)
 	{ }
-
-
-	bool VideoRGBAShader::init(utility::ErrorState& errorState)
-	{
-		if (!Shader::init(errorState))
-			return false;
-
-        auto* videoadvanced_service = mRenderService->getCore().getService<VideoAdvancedService>();
-
-        std::string relative_path = utility::joinPath({ "shaders", utility::appendFileExtension(shader::videorgba, "vert") });
-        const std::string vertex_shader_path = videoadvanced_service->getModule().findAsset(relative_path);
-        if (!errorState.check(!vertex_shader_path.empty(), "%s: Unable to find %s vertex shader %s", mRenderService->getModule().getName().c_str(), shader::videorgba, vertex_shader_path.c_str()))
-            return false;
-
-        relative_path = utility::joinPath({ "shaders", utility::appendFileExtension(shader::videorgba, "frag") });
-        const std::string fragment_shader_path = videoadvanced_service->getModule().findAsset(relative_path);
-        if (!errorState.check(!vertex_shader_path.empty(), "%s: Unable to find %s fragment shader %s", mRenderService->getModule().getName().c_str(), shader::videorgba, fragment_shader_path.c_str()))
-            return false;
-
-        // Read vert shader file
-        std::string vert_source;
-        if (!errorState.check(utility::readFileToString(vertex_shader_path, vert_source, errorState), "Unable to read %s vertex shader file", shader::videorgba))
-            return false;
-
-        // Read frag shader file
-        std::string frag_source;
-        if (!errorState.check(utility::readFileToString(fragment_shader_path, frag_source, errorState), "Unable to read %s fragment shader file", shader::videorgba))
-            return false;
-
-        // Copy data search paths
-        const auto search_paths = videoadvanced_service->getModule().getInformation().mDataSearchPaths;
-
-        // Compile shader
-        return this->load(shader::videorgba, search_paths, vert_source.data(), vert_source.size(), frag_source.data(), frag_source.size(), errorState);
-	}
 }
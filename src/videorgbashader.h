@@ -4,20 +4,20 @@
 
 #pragma once
 
-// External Includes
-#include <shader.h>
+// Local Includes
+#include "videoadvancedshader.h"
 
 namespace nap
 {
-	// Forward declares
-	class Core;
-	class RenderService;
-
-	// Video shader sampler names
+	// Video shader uniform and sampler names
 	namespace uniform
 	{
 		namespace videorgba
 		{
+			inline constexpr const char* uboStruct = "UBO";
+			inline constexpr const char* swapRedBlue = "swapRedBlue";
+			inline constexpr const char* opaque = "opaque";
+
 			namespace sampler
 			{
 				inline constexpr const char* RGBASampler  = "Texture";
@@ -27,21 +27,12 @@ namespace nap
 
     /**
      * Video RGBA shader for rendering RGBA ideo frames.
+     * Swaps red and blue for BGRA frames, and ignores the alpha channel of formats without alpha (RGB0, BGR0).
      */
-	class NAPAPI VideoRGBAShader : public Shader
+	class NAPAPI VideoRGBAShader : public VideoAdvancedShader
 	{
-		RTTI_ENABLE(Shader)
+		RTTI_ENABLE(VideoAdvancedShader)
 	public:
         VideoRGBAShader(Core& core);
-
-		/**
-		 * Cross compiles the video GLSL shader code to SPIR-V, creates the shader module and parses all the uniforms and samplers.
-		 * @param errorState contains the error if initialization fails.
-		 * @return if initialization succeeded.
-		 */
-		virtual bool init(utility::ErrorState& errorState) override;
-
-	private:
-		RenderService* mRenderService = nullptr;
 	};
 }
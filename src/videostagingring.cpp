@@ -0,0 +1,216 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// Local Includes
+#include "videostagingring.h"
+#include "videoplanetransform.h"
+
+// External Includes
+#include <renderservice.h>
+#include <nap/assert.h>
+
+extern "C"
+{
+#include <libavutil/frame.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+}
+
+namespace nap
+{
+    // Slot states
+    static constexpr int sSlotFree = 0;         // Available to the worker
+    static constexpr int sSlotFilled = 1;       // Holds a frame, owned by the main thread
+    static constexpr int sSlotInFlight = 2;     // Copied in a frame the GPU has not finished yet
+
+    // Planes start at an offset that satisfies the buffer to image copy alignment of all texel sizes
+    static constexpr VkDeviceSize sPlaneAlignment = 16;
+
+
+    VideoStagingRing::VideoStagingRing(RenderService& renderService) :
+        mRenderService(renderService)
+    { }
+
+
+    VideoStagingRing::~VideoStagingRing()
+    {
+        // Buffers can still be read by frames in flight, destroy them when the GPU is done with them
+        for (auto& slot : mSlots)
+        {
+            av_frame_free(&slot->mFrame);
+            if (slot->mBuffer == VK_NULL_HANDLE)
+                continue;
+
+            VkBuffer buffer = slot->mBuffer;
+            VmaAllocation allocation = slot->mAllocation;
+            mRenderService.queueVulkanObjectDestructor([buffer, allocation](RenderService& renderService)
+            {
+                vmaDestroyBuffer(renderService.getVulkanAllocator(), buffer, allocation);
+            });
+        }
+    }
+
+
+    void VideoStagingRing::init(int slotCount)
+    {
+        assert(mSlots.empty() && slotCount > 0);
+        mSlots.reserve(slotCount);
+        for (int i = 0; i < slotCount; i++)
+        {
+            auto& slot = mSlots.emplace_back(std::make_unique<Slot>());
+            slot->mFrame = av_frame_alloc();
+        }
+    }
+
+
+    int VideoStagingRing::fill(const Frame& frame, int format, Frame& outFrame)
+    {
+        assert(frame.isValid());
+        AVFrame* av_frame = frame.mFrame;
+        auto pixel_format = static_cast<AVPixelFormat>(av_frame->format);
+
+        // Hardware frames and bitstream formats have no planes in system memory
+        const AVPixFmtDescriptor* descriptor = av_pix_fmt_desc_get(pixel_format);
+        if (descriptor == nullptr || (descriptor->flags & (AV_PIX_FMT_FLAG_HWACCEL | AV_PIX_FMT_FLAG_BITSTREAM)) != 0)
+            return -1;
+
+        // Tightly packed plane layout of the staged format
+        auto staged_format = static_cast<AVPixelFormat>(format);
+        int row_bytes[4] = { 0 };
+        int plane_count = av_pix_fmt_count_planes(staged_format);
+        if (plane_count <= 0 || plane_count > maxPlanes || av_image_fill_linesizes(row_bytes, staged_format, av_frame->width) < 0)
+            return -1;
+
+        std::array<Plane, maxPlanes> planes;
+        VkDeviceSize size = 0;
+        for (int i = 0; i < plane_count; i++)
+        {
+            bool chroma = i == 1 || i == 2;
+            planes[i].mOffset = size;
+            planes[i].mRowBytes = static_cast<uint32>(row_bytes[i]);
+            planes[i].mRows = static_cast<uint32>(chroma ? AV_CEIL_RSHIFT(av_frame->height, descriptor->log2_chroma_h) : av_frame->height);
+            size += (static_cast<VkDeviceSize>(planes[i].mRowBytes) * planes[i].mRows + sPlaneAlignment - 1) & ~(sPlaneAlignment - 1);
+        }
+
+        // Find a free slot, starting at the one after the last filled slot
+        Slot* slot = nullptr;
+        int index = -1;
+        for (int i = 0; i < static_cast<int>(mSlots.size()); i++)
+        {
+            int candidate = (mNextSlot + i) % static_cast<int>(mSlots.size());
+            if (mSlots[candidate]->mState.load(std::memory_order_acquire) == sSlotFree)
+            {
+                slot = mSlots[candidate].get();
+                index = candidate;
+                break;
+            }
+        }
+
+        if (slot == nullptr || !reserve(*slot, size))
+            return -1;
+
+        // Copy or transform the planes
+        uint8* plane_data[4] = { nullptr };
+        int plane_row_bytes[4] = { 0 };
+        for (int i = 0; i < plane_count; i++)
+        {
+            plane_data[i] = slot->mData + planes[i].mOffset;
+            plane_row_bytes[i] = static_cast<int>(planes[i].mRowBytes);
+        }
+
+        if (!utility::transformVideoFrame(*av_frame, staged_format, plane_data, plane_row_bytes))
+            return -1;
+
+        slot->mPlanes = planes;
+        slot->mPlaneCount = plane_count;
+
+        // The staged frame refers to the buffer, it owns no data
+        AVFrame* staged_frame = slot->mFrame;
+        staged_frame->format = staged_format;
+        staged_frame->width = av_frame->width;
+        staged_frame->height = av_frame->height;
+        for (int i = 0; i < AV_NUM_DATA_POINTERS; i++)
+        {
+            staged_frame->data[i] = i < plane_count ? slot->mData + planes[i].mOffset : nullptr;
+            staged_frame->linesize[i] = i < plane_count ? static_cast<int>(planes[i].mRowBytes) : 0;
+        }
+        outFrame.mFrame = staged_frame;
+        outFrame.mPTSSecs = frame.mPTSSecs;
+
+        // Hand the slot to the main thread
+        mNextSlot = (index + 1) % static_cast<int>(mSlots.size());
+        slot->mState.store(sSlotFilled, std::memory_order_release);
+        return index;
+    }
+
+
+    void VideoStagingRing::markInFlight(int index)
+    {
+        auto& slot = *mSlots[index];
+        assert(slot.mState.load(std::memory_order_relaxed) == sSlotFilled);
+        slot.mReleaseFrame = mFrame + mRenderService.getMaxFramesInFlight();
+        slot.mState.store(sSlotInFlight, std::memory_order_relaxed);
+    }
+
+
+    void VideoStagingRing::release(int index)
+    {
+        assert(mSlots[index]->mState.load(std::memory_order_relaxed) == sSlotFilled);
+        mSlots[index]->mState.store(sSlotFree, std::memory_order_release);
+    }
+
+
+    void VideoStagingRing::update()
+    {
+        // The render service waits for the frame that used the same frame in flight resources before it starts recording,
+        // once that many updates passed the copies recorded for a slot are finished
+        mFrame++;
+        for (auto& slot : mSlots)
+        {
+            if (slot->mState.load(std::memory_order_relaxed) == sSlotInFlight && slot->mReleaseFrame < mFrame)
+                slot->mState.store(sSlotFree, std::memory_order_release);
+        }
+    }
+
+
+    bool VideoStagingRing::reserve(Slot& slot, VkDeviceSize size)
+    {
+        if (slot.mBuffer != VK_NULL_HANDLE && slot.mSize >= size)
+            return true;
+
+        // The slot is free, the GPU no longer reads the old buffer
+        VmaAllocator allocator = mRenderService.getVulkanAllocator();
+        if (slot.mBuffer != VK_NULL_HANDLE)
+        {
+            vmaDestroyBuffer(allocator, slot.mBuffer, slot.mAllocation);
+            slot.mBuffer = VK_NULL_HANDLE;
+            slot.mAllocation = nullptr;
+            slot.mData = nullptr;
+            slot.mSize = 0;
+        }
+
+        VkBufferCreateInfo buffer_info = {};
+        buffer_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        buffer_info.size = size;
+        buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+        buffer_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        // Host visible and coherent, mapped for the lifetime of the buffer
+        VmaAllocationCreateInfo allocation_info = {};
+        allocation_info.usage = VMA_MEMORY_USAGE_CPU_ONLY;
+        allocation_info.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+        VmaAllocationInfo allocation_result = {};
+        if (vmaCreateBuffer(allocator, &buffer_info, &allocation_info, &slot.mBuffer, &slot.mAllocation, &allocation_result) != VK_SUCCESS)
+        {
+            slot.mBuffer = VK_NULL_HANDLE;
+            slot.mAllocation = nullptr;
+            return false;
+        }
+
+        slot.mData = static_cast<uint8*>(allocation_result.pMappedData);
+        slot.mSize = size;
+        return true;
+    }
+}
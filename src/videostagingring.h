@@ -0,0 +1,125 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+// External Includes
+#include <video.h>
+#include <nap/numeric.h>
+#include <utility/dllexport.h>
+#include <vk_mem_alloc.h>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace nap
+{
+    // Forward declares
+    class RenderService;
+
+    /**
+     * Ring of persistently mapped, host visible staging buffers, one buffer per decoded frame.
+     * The decode worker copies all planes of a frame into a free buffer, tightly packed, the main thread
+     * only records the buffer to image copies. A buffer is reused once the GPU finished the frame it was copied in.
+     *
+     * The staged frame of a slot refers to the buffer, it can be uploaded with a regular texture update as well.
+     * Slots move from free to filled on the worker, and from filled to in flight and back to free on the main thread.
+     * Single producer (the decode worker), single consumer (the main thread).
+     */
+    class NAPAPI VideoStagingRing final
+    {
+    public:
+        static constexpr int maxPlanes = 4;
+
+        /**
+         * Location of a single frame plane in a staging buffer
+         */
+        struct Plane
+        {
+            VkDeviceSize mOffset = 0;               ///< Offset of the plane in the buffer, in bytes
+            uint32 mRowBytes = 0;                   ///< Size of a row in bytes, rows are tightly packed
+            uint32 mRows = 0;                       ///< Number of rows
+        };
+
+        /**
+         * Staging buffer that holds all planes of a single frame
+         */
+        struct Slot
+        {
+            VkBuffer mBuffer = VK_NULL_HANDLE;      ///< Staging buffer
+            VmaAllocation mAllocation = nullptr;    ///< Memory of the staging buffer, persistently mapped
+            uint8* mData = nullptr;                 ///< Mapped memory
+            VkDeviceSize mSize = 0;                 ///< Size of the buffer in bytes
+            std::array<Plane, maxPlanes> mPlanes;   ///< Planes of the staged frame
+            int mPlaneCount = 0;                    ///< Number of planes of the staged frame
+            AVFrame* mFrame = nullptr;              ///< Frame that refers to the planes in the buffer, owned by the slot
+            std::atomic<int> mState = { 0 };        ///< Free, filled or in flight
+            uint64 mReleaseFrame = 0;               ///< Update after which the GPU finished reading the buffer, main thread only
+        };
+
+        /**
+         * @param renderService the render service, provides the allocator and the number of frames in flight
+         */
+        VideoStagingRing(RenderService& renderService);
+
+        /**
+         * Frees the slot frames and queues all staging buffers for destruction, call on the main thread
+         */
+        ~VideoStagingRing();
+
+        /**
+         * Creates the slots, buffers are allocated on first use.
+         * @param slotCount number of slots, at least the number of frames decoded ahead plus the number of frames in flight
+         */
+        void init(int slotCount);
+
+        /**
+         * Copies all planes of a decoded frame into a free staging buffer, call on the decode worker.
+         * The planes are transformed on the way into the buffer when the given format differs from the format of the frame,
+         * see utility::getVideoTransformFormat(), the staged frame is of the given format.
+         * The staged frame refers to the planes in the buffer, rows are tightly packed: the row pitch matches the textures.
+         * It stays valid until the slot is released and must not be freed, the decoded frame can be released right away.
+         * @param frame the decoded frame to stage
+         * @param format the pixel format to store the planes in
+         * @param outFrame the staged frame, with the presentation time of the decoded frame
+         * @return index of the slot that holds the frame, -1 when no slot is free or the buffer can't be allocated
+         */
+        int fill(const Frame& frame, int format, Frame& outFrame);
+
+        /**
+         * @param index index of a filled slot
+         * @return the slot
+         */
+        const Slot& getSlot(int index) const        { return *mSlots[index]; }
+
+        /**
+         * Marks a filled slot as read by the GPU in the current frame, call on the main thread after recording the copies.
+         * @param index index of the slot
+         */
+        void markInFlight(int index);
+
+        /**
+         * Returns a filled slot that is not copied to the GPU, call on the main thread.
+         * @param index index of the slot
+         */
+        void release(int index);
+
+        /**
+         * Frees all slots the GPU is done with, call on the main thread once per update.
+         */
+        void update();
+
+    private:
+        /**
+         * Makes sure the buffer of a slot can hold the given number of bytes, call on the decode worker.
+         */
+        bool reserve(Slot& slot, VkDeviceSize size);
+
+        RenderService& mRenderService;                  ///< Render service
+        std::vector<std::unique_ptr<Slot>> mSlots;      ///< All slots
+        int mNextSlot = 0;                              ///< Slot the worker tries first, worker only
+        uint64 mFrame = 0;                              ///< Number of updates, main thread only
+    };
+}
@@ -0,0 +1,216 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// Local Includes
+#include "videoworkerpool.h"
+
+// External Includes
+#include <algorithm>
+
+namespace nap
+{
+    // Pool and worker index of the calling thread, used to push tasks enqueued by a worker onto its own queue
+    static thread_local VideoWorkerPool* sCurrentPool = nullptr;
+    static thread_local int sCurrentWorker = -1;
+
+    // Number of tasks the calling thread is running from tryRunPendingTask, a helped task can wait and help out itself
+    static thread_local int sHelpDepth = 0;
+
+    // Max number of nested tasks a thread runs while waiting, bounds the stack use of tasks that wait on each other
+    static constexpr int sMaxHelpDepth = 4;
+
+
+    VideoWorkerPool::VideoWorkerPool(int numThreads)
+    {
+        if (numThreads <= 0)
+            numThreads = std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 1);
+
+        // Create all workers before starting any thread, workers steal from each other
+        for (int i = 0; i < numThreads; i++)
+            mWorkers.emplace_back(std::make_unique<Worker>());
+
+        for (int i = 0; i < numThreads; i++)
+            mWorkers[i]->mThread = std::thread(&VideoWorkerPool::onWork, this, i);
+    }
+
+
+    VideoWorkerPool::~VideoWorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+            mRunning = false;
+        }
+        mSleepSignal.notify_all();
+
+        for (auto& worker : mWorkers)
+        {
+            if (worker->mThread.joinable())
+                worker->mThread.join();
+        }
+    }
+
+
+    void VideoWorkerPool::enqueue(Task task)
+    {
+        // Push onto the queue of the calling worker, otherwise distribute
+        int index = sCurrentPool == this ? sCurrentWorker :
+            static_cast<int>(mNextWorker.fetch_add(1, std::memory_order_relaxed) % mWorkers.size());
+
+        auto& worker = *mWorkers[index];
+        {
+            std::lock_guard<std::mutex> lock(worker.mMutex);
+            worker.mTasks.emplace_back(std::move(task));
+        }
+
+        // Increment under the sleep mutex, this ensures a worker that is about to sleep can't miss the signal
+        {
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+            mPendingTasks.fetch_add(1, std::memory_order_release);
+        }
+        mSleepSignal.notify_one();
+    }
+
+
+    void VideoWorkerPool::enqueueAt(SteadyTimeStamp time, Task task)
+    {
+        bool earliest = false;
+        {
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+            earliest = mTimers.empty() || time < mTimers.front().mTime;
+            mTimers.emplace_back(Timer{ time, std::move(task) });
+            std::push_heap(mTimers.begin(), mTimers.end(), std::greater<Timer>());
+            mTimerCount.fetch_add(1, std::memory_order_release);
+            if (earliest)
+                mTimerGeneration++;
+        }
+
+        // Sleeping workers wait for the previous earliest timer, or for a task when there was none:
+        // wake one up, it sleeps again until the new earliest timer
+        if (earliest)
+            mSleepSignal.notify_one();
+    }
+
+
+    void VideoWorkerPool::enqueueDueTimers()
+    {
+        if (mTimerCount.load(std::memory_order_acquire) == 0)
+            return;
+
+        // Collect due tasks, enqueue them outside of the sleep lock
+        std::vector<Task> due_tasks;
+        {
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+            SteadyTimeStamp now = SteadyClock::now();
+            while (!mTimers.empty() && mTimers.front().mTime <= now)
+            {
+                std::pop_heap(mTimers.begin(), mTimers.end(), std::greater<Timer>());
+                due_tasks.emplace_back(std::move(mTimers.back().mTask));
+                mTimers.pop_back();
+                mTimerCount.fetch_sub(1, std::memory_order_acq_rel);
+            }
+        }
+
+        for (auto& task : due_tasks)
+            enqueue(std::move(task));
+    }
+
+
+    bool VideoWorkerPool::tryRunPendingTask()
+    {
+        if (sHelpDepth >= sMaxHelpDepth)
+            return false;
+
+        Task task;
+        int index = sCurrentPool == this ? sCurrentWorker : 0;
+        if (!popTask(index, task) && !stealTask(index, task))
+            return false;
+
+        sHelpDepth++;
+        task();
+        sHelpDepth--;
+        return true;
+    }
+
+
+    bool VideoWorkerPool::isWorkerThread() const
+    {
+        return sCurrentPool == this;
+    }
+
+
+    bool VideoWorkerPool::popTask(int index, Task& task)
+    {
+        // Take the most recently added task from our own queue, it's most likely to be warm in cache
+        auto& worker = *mWorkers[index];
+        std::lock_guard<std::mutex> lock(worker.mMutex);
+        if (worker.mTasks.empty())
+            return false;
+
+        task = std::move(worker.mTasks.back());
+        worker.mTasks.pop_back();
+        mPendingTasks.fetch_sub(1, std::memory_order_acq_rel);
+        return true;
+    }
+
+
+    bool VideoWorkerPool::stealTask(int index, Task& task)
+    {
+        // Steal the oldest task from the other workers, starting with our neighbour
+        int count = static_cast<int>(mWorkers.size());
+        for (int i = 1; i < count; i++)
+        {
+            auto& victim = *mWorkers[(index + i) % count];
+            std::unique_lock<std::mutex> lock(victim.mMutex, std::try_to_lock);
+            if (!lock.owns_lock() || victim.mTasks.empty())
+                continue;
+
+            task = std::move(victim.mTasks.front());
+            victim.mTasks.pop_front();
+            mPendingTasks.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+        }
+        return false;
+    }
+
+
+    void VideoWorkerPool::onWork(int index)
+    {
+        sCurrentPool = this;
+        sCurrentWorker = index;
+
+        Task task;
+        while (mRunning)
+        {
+            enqueueDueTimers();
+            if (popTask(index, task) || stealTask(index, task))
+            {
+                task();
+                task = nullptr;
+                continue;
+            }
+
+            // Nothing to do, sleep until new tasks are enqueued, the next timer is due or an earlier timer is added.
+            // The loop enqueues due timers and reads the earliest deadline again after every wake up
+            std::unique_lock<std::mutex> lock(mSleepMutex);
+            uint64 timer_generation = mTimerGeneration;
+            auto wake_up = [this, timer_generation]
+            {
+                return mPendingTasks.load(std::memory_order_acquire) > 0 || !mRunning || mTimerGeneration != timer_generation;
+            };
+            if (mTimers.empty())
+            {
+                mSleepSignal.wait(lock, wake_up);
+            }
+            else
+            {
+                // Copy the deadline, the timer heap can grow while waiting
+                SteadyTimeStamp deadline = mTimers.front().mTime;
+                mSleepSignal.wait_until(lock, deadline, wake_up);
+            }
+        }
+
+        sCurrentPool = nullptr;
+        sCurrentWorker = -1;
+    }
+}
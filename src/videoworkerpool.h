@@ -0,0 +1,107 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+// External Includes
+#include <nap/numeric.h>
+#include <nap/datetime.h>
+#include <utility/dllexport.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nap
+{
+    /**
+     * Fixed size work-stealing thread pool, owned by the VideoAdvancedService.
+     * Every worker owns a task queue. Tasks enqueued from a worker thread are pushed onto the queue of that worker,
+     * tasks enqueued from any other thread are distributed round-robin. Idle workers steal from the queues of other workers.
+     * The pool does not guarantee ordering between tasks, callers that require ordering (like the threaded video player)
+     * must ensure only one of their tasks is in flight at any given time.
+     */
+    class NAPAPI VideoWorkerPool final
+    {
+    public:
+        using Task = std::function<void()>;
+
+        /**
+         * Creates and starts the pool
+         * @param numThreads number of worker threads, 0 selects the number of hardware threads minus one
+         */
+        explicit VideoWorkerPool(int numThreads);
+
+        /**
+         * Stops and joins all worker threads, pending tasks are discarded
+         */
+        ~VideoWorkerPool();
+
+        /**
+         * Enqueues a task, thread safe
+         * @param task the task to execute on one of the workers
+         */
+        void enqueue(Task task);
+
+        /**
+         * Enqueues a task that becomes available for execution at the given point in time, thread safe.
+         * @param time point in time at which the task is enqueued
+         * @param task the task to execute on one of the workers
+         */
+        void enqueueAt(SteadyTimeStamp time, Task task);
+
+        /**
+         * Executes at most one pending task on the calling thread, if available.
+         * Use this to help out while waiting for tasks to complete, instead of blocking a worker.
+         * A task executed here can wait and help out in turn, nesting is bounded to a few tasks per thread:
+         * beyond that nothing is executed and the caller has to yield until its tasks complete.
+         * @return if a task was executed
+         */
+        bool tryRunPendingTask();
+
+        /**
+         * @return number of worker threads
+         */
+        int getThreadCount() const { return static_cast<int>(mWorkers.size()); }
+
+        /**
+         * @return if the calling thread is one of the workers of this pool
+         */
+        bool isWorkerThread() const;
+
+    private:
+        struct Worker
+        {
+            std::mutex mMutex;                      ///< Guards the task queue
+            std::deque<Task> mTasks;                ///< Task queue of this worker
+            std::thread mThread;                    ///< The worker thread
+        };
+
+        struct Timer
+        {
+            SteadyTimeStamp mTime;                  ///< Point in time the task is enqueued
+            Task mTask;                             ///< The task to enqueue
+            bool operator>(const Timer& other) const { return mTime > other.mTime; }
+        };
+
+        void onWork(int index);
+        bool popTask(int index, Task& task);
+        bool stealTask(int index, Task& task);
+        void enqueueDueTimers();
+
+        std::vector<std::unique_ptr<Worker>> mWorkers;  ///< All workers
+        std::atomic<uint32> mNextWorker = { 0 };        ///< Round robin index for tasks enqueued from outside the pool
+        std::atomic<int> mPendingTasks = { 0 };         ///< Total number of queued tasks
+        std::atomic_bool mRunning = { true };           ///< If the pool is running
+        std::mutex mSleepMutex;                         ///< Mutex for the sleep signal and timers
+        std::condition_variable mSleepSignal;           ///< Wakes up idle workers
+        std::vector<Timer> mTimers;                     ///< Min heap of delayed tasks, guarded by the sleep mutex
+        std::atomic<int> mTimerCount = { 0 };           ///< Number of delayed tasks
+        uint64 mTimerGeneration = 0;                    ///< Advances when the earliest timer changes, guarded by the sleep mutex
+    };
+}
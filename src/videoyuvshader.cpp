@@ -0,0 +1,39 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// Local includes
+#include "videoyuvshader.h"
+
+// nap::VideoYUVShader run time class definition
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoYUVShader)
+	RTTI_CONSTRUCTOR(nap::Core&)
+RTTI_END_CLASS
+
+// nap::VideoYUVAShader run time class definition
+RTTI_BEGIN_CLASS_NO_DEFAULT_CONSTRUCTOR(nap::VideoYUVAShader)
+	RTTI_CONSTRUCTOR(nap::Core&)
+RTTI_END_CLASS
+
+
+//////////////////////////////////////////////////////////////////////////
+// VideoYUVShader
+//////////////////////////////////////////////////////////////////////////
+
+namespace nap
+{
+	namespace shader
+	{
+		inline constexpr const char* videoyuv = "videoyuv";
+		inline constexpr const char* videoyuva = "videoyuva";
+		inline constexpr const char* videoyuvvert = "videorgba";
+	}
+
+
+	VideoYUVShader::VideoYUVShader(Core& core) : VideoAdvancedShader(core, shader::videoyuvvert, shader::videoyuv)
+	{ }
+
+
+	VideoYUVAShader::VideoYUVAShader(Core& core) : VideoAdvancedShader(core, shader::videoyuvvert, shader::videoyuva)
+	{ }
+}
@@ -0,0 +1,53 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+#pragma once
+
+// Local Includes
+#include "videoadvancedshader.h"
+
+namespace nap
+{
+	// Video shader uniform and sampler names
+	namespace uniform
+	{
+		namespace videoyuv
+		{
+			inline constexpr const char* uboStruct = "UBO";
+			inline constexpr const char* sampleScale = "sampleScale";
+			inline constexpr const char* premultiplyAlpha = "premultiplyAlpha";
+
+			namespace sampler
+			{
+				inline constexpr const char* YSampler = "yTexture";
+				inline constexpr const char* USampler = "uTexture";
+				inline constexpr const char* VSampler = "vTexture";
+				inline constexpr const char* ASampler = "aTexture";
+			}
+		}
+	}
+
+	/**
+	 * Video shader for rendering planar YUV video frames of any chroma subsampling and bit depth.
+	 * Samples are multiplied by 'sampleScale' to normalize samples of less than 16 bits stored in 16 bit textures.
+	 */
+	class NAPAPI VideoYUVShader : public VideoAdvancedShader
+	{
+		RTTI_ENABLE(VideoAdvancedShader)
+	public:
+		VideoYUVShader(Core& core);
+	};
+
+
+	/**
+	 * Video shader for rendering planar YUV video frames with an alpha plane, of any chroma subsampling and bit depth.
+	 * Outputs straight alpha, or alpha premultiplied color when 'premultiplyAlpha' is set.
+	 */
+	class NAPAPI VideoYUVAShader : public VideoAdvancedShader
+	{
+		RTTI_ENABLE(VideoAdvancedShader)
+	public:
+		VideoYUVAShader(Core& core);
+	};
+}
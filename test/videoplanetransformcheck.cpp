@@ -0,0 +1,384 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+
+// Standalone equivalence check and benchmark of the plane transforms in src/videoplanetransform.cpp.
+// The plane functions dispatch to the SIMD kernel the CPU supports, every result is compared with a scalar reference.
+// Covers row tails shorter than a vector, unaligned rows, padded strides and big endian input.
+// Guard bytes after every destination row catch kernels that write past the end of a row.
+// Afterwards every kernel is timed against the scalar reference on a 1920x1080 plane, in MB/s of source data.
+//
+// Built by the 'videoplanetransformcheck' target when NAPVIDEOADVANCED_BUILD_CHECKS is enabled, see module_extra.cmake.
+// Without the NAP build, compile it together with the transform, for example:
+//   c++ -std=c++17 -O2 -I src -I <nap>/core/src -I <nap>/utility/src -I <ffmpeg>/include
+//       test/videoplanetransformcheck.cpp src/videoplanetransform.cpp -L <ffmpeg>/lib -lavutil
+// Exits with 0 when all transforms match the reference, pass --no-benchmark to skip the timing.
+
+// Local Includes
+#include <videoplanetransform.h>
+
+// External Includes
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <vector>
+
+using namespace nap;
+
+// Written after the last byte of every destination row, must be left untouched
+static constexpr uint8 sGuard = 0xa5;
+
+// Number of guard bytes after a destination row
+static constexpr int sGuardSize = 16;
+
+// Number of rows of a checked plane, more than the 8 rows of the dither matrix
+static constexpr int sRows = 11;
+
+// Size of the benchmarked planes
+static constexpr int sBenchmarkWidth = 1920;
+static constexpr int sBenchmarkHeight = 1080;
+
+// Min time a kernel is run for, in seconds
+static constexpr double sBenchmarkTime = 0.25;
+
+// Row lengths in samples or pixels: every tail length below 16, a few full vectors and vectors with a tail
+static const std::vector<int> sCounts = []()
+{
+    std::vector<int> counts;
+    for (int i = 1; i <= 17; i++)
+        counts.emplace_back(i);
+    for (int i : { 31, 32, 33, 47, 48, 63, 64, 65, 127, 1921 })
+        counts.emplace_back(i);
+    return counts;
+}();
+
+// Byte offsets of the first row, to run the kernels on unaligned rows
+static const std::vector<int> sOffsets = { 0, 1, 3 };
+
+// 8x8 ordered dither matrix, thresholds 0 to 63, must match the transform
+static constexpr int sBayerMatrix[8][8] =
+{
+    {  0, 32,  8, 40,  2, 34, 10, 42 },
+    { 48, 16, 56, 24, 50, 18, 58, 26 },
+    { 12, 44,  4, 36, 14, 46,  6, 38 },
+    { 60, 28, 52, 20, 62, 30, 54, 22 },
+    {  3, 35, 11, 43,  1, 33,  9, 41 },
+    { 51, 19, 59, 27, 49, 17, 57, 25 },
+    { 15, 47,  7, 39, 13, 45,  5, 37 },
+    { 63, 31, 55, 23, 61, 29, 53, 21 }
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+// Scalar reference
+//////////////////////////////////////////////////////////////////////////
+
+static void expandRGB24Reference(const uint8* src, int srcStride, uint8* dst, int dstStride, int width, int height)
+{
+    for (int row = 0; row < height; row++)
+    {
+        const uint8* pixel = src + row * srcStride;
+        uint8* result = dst + row * dstStride;
+        for (int i = 0; i < width; i++, pixel += 3, result += 4)
+        {
+            result[0] = pixel[0];
+            result[1] = pixel[1];
+            result[2] = pixel[2];
+            result[3] = 0xff;
+        }
+    }
+}
+
+
+static void swapBytes16Reference(const uint8* src, int srcStride, uint8* dst, int dstStride, int count, int height)
+{
+    for (int row = 0; row < height; row++)
+    {
+        const uint8* sample = src + row * srcStride;
+        uint8* result = dst + row * dstStride;
+        for (int i = 0; i < count; i++, sample += 2, result += 2)
+        {
+            uint8 first = sample[0];
+            result[0] = sample[1];
+            result[1] = first;
+        }
+    }
+}
+
+
+static void ditherTo8BitReference(const uint8* src, int srcStride, uint8* dst, int dstStride, int count, int height, int bits, bool bigEndian)
+{
+    // Samples can hold bits above the depth of the format, the transform clamps them to white
+    int shift = bits - 8;
+    for (int row = 0; row < height; row++)
+    {
+        const uint8* bytes = src + row * srcStride;
+        uint8* result = dst + row * dstStride;
+        for (int i = 0; i < count; i++, bytes += 2)
+        {
+            int sample = bigEndian ? (bytes[0] << 8) | bytes[1] : bytes[0] | (bytes[1] << 8);
+            int dither = (sBayerMatrix[row & 7][i & 7] << shift) >> 6;
+            result[i] = static_cast<uint8>(std::min(std::min(sample + dither, 0xffff) >> shift, 0xff));
+        }
+    }
+}
+
+
+static void interleaveReference(const uint8* first, int firstStride, const uint8* second, int secondStride, uint8* dst, int dstStride, int count, int height)
+{
+    for (int row = 0; row < height; row++)
+    {
+        uint8* result = dst + row * dstStride;
+        for (int i = 0; i < count; i++, result += 2)
+        {
+            result[0] = first[row * firstStride + i];
+            result[1] = second[row * secondStride + i];
+        }
+    }
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Planes
+//////////////////////////////////////////////////////////////////////////
+
+/**
+ * Destination plane with guard bytes after every row
+ */
+struct Plane
+{
+    Plane(int offset, int rowSize, int rows = sRows) :
+        mOffset(offset), mRowSize(rowSize), mRows(rows), mStride(rowSize + sGuardSize), mData(offset + mStride * rows, sGuard)
+    { }
+
+    uint8* getRow(int row)              { return mData.data() + mOffset + row * mStride; }
+    uint8* getData()                    { return getRow(0); }
+
+    /**
+     * @return if the guard bytes of every row are intact
+     */
+    bool checkGuards()
+    {
+        for (int row = 0; row < mRows; row++)
+        {
+            const uint8* guard = getRow(row) + mRowSize;
+            if (std::any_of(guard, guard + sGuardSize, [](uint8 value) { return value != sGuard; }))
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * @return if the rows of both planes are equal, guard bytes are not compared
+     */
+    bool operator==(Plane& other)
+    {
+        for (int row = 0; row < mRows; row++)
+        {
+            if (std::memcmp(getRow(row), other.getRow(row), mRowSize) != 0)
+                return false;
+        }
+        return true;
+    }
+
+    int mOffset = 0;
+    int mRowSize = 0;
+    int mRows = 0;
+    int mStride = 0;
+    std::vector<uint8> mData;
+};
+
+
+/**
+ * Source plane of random bytes, rows are padded
+ */
+struct Source
+{
+    Source(std::mt19937& random, int offset, int rowSize, int rows = sRows) :
+        mOffset(offset), mStride(rowSize + 7), mData(offset + mStride * rows)
+    {
+        std::uniform_int_distribution<int> distribution(0, 255);
+        for (auto& value : mData)
+            value = static_cast<uint8>(distribution(random));
+
+        // Include the extremes, the dither saturates on white
+        if (rowSize >= 4 && rows >= 2)
+        {
+            std::fill(getRow(0), getRow(0) + 4, 0xff);
+            std::fill(getRow(1), getRow(1) + 4, 0x00);
+        }
+    }
+
+    uint8* getRow(int row)              { return mData.data() + mOffset + row * mStride; }
+    const uint8* getData()              { return getRow(0); }
+
+    int mOffset = 0;
+    int mStride = 0;
+    std::vector<uint8> mData;
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+// Checks
+//////////////////////////////////////////////////////////////////////////
+
+static int sFailures = 0;
+static int sChecks = 0;
+
+static void report(Plane& result, Plane& expected, const char* transform, int count, int offset, const char* variant = "")
+{
+    sChecks++;
+    if (result.checkGuards() && result == expected)
+        return;
+
+    std::printf("FAILED: %s%s, %d samples, offset %d\n", transform, variant, count, offset);
+    sFailures++;
+}
+
+
+static void checkExpandRGB24(std::mt19937& random, int count, int offset)
+{
+    Source src(random, offset, count * 3);
+    Plane result(offset, count * 4), expected(offset, count * 4);
+    utility::expandRGB24Plane(src.getData(), src.mStride, result.getData(), result.mStride, count, sRows);
+    expandRGB24Reference(src.getData(), src.mStride, expected.getData(), expected.mStride, count, sRows);
+    report(result, expected, "expandRGB24Plane", count, offset);
+}
+
+
+static void checkSwapBytes16(std::mt19937& random, int count, int offset)
+{
+    Source src(random, offset, count * 2);
+    Plane result(offset, count * 2), expected(offset, count * 2);
+    utility::swapBytes16Plane(src.getData(), src.mStride, result.getData(), result.mStride, count, sRows);
+    swapBytes16Reference(src.getData(), src.mStride, expected.getData(), expected.mStride, count, sRows);
+    report(result, expected, "swapBytes16Plane", count, offset);
+}
+
+
+static void checkDitherTo8Bit(std::mt19937& random, int count, int offset, int bits, bool bigEndian)
+{
+    Source src(random, offset, count * 2);
+    Plane result(offset, count), expected(offset, count);
+    utility::ditherTo8BitPlane(src.getData(), src.mStride, result.getData(), result.mStride, count, sRows, bits, bigEndian);
+    ditherTo8BitReference(src.getData(), src.mStride, expected.getData(), expected.mStride, count, sRows, bits, bigEndian);
+
+    char variant[32];
+    std::snprintf(variant, sizeof(variant), " %d bit %s", bits, bigEndian ? "BE" : "LE");
+    report(result, expected, "ditherTo8BitPlane", count, offset, variant);
+}
+
+
+static void checkInterleave(std::mt19937& random, int count, int offset)
+{
+    Source first(random, offset, count);
+    Source second(random, offset + 2, count);
+    Plane result(offset, count * 2), expected(offset, count * 2);
+    utility::interleavePlanes(first.getData(), first.mStride, second.getData(), second.mStride, result.getData(), result.mStride, count, sRows);
+    interleaveReference(first.getData(), first.mStride, second.getData(), second.mStride, expected.getData(), expected.mStride, count, sRows);
+    report(result, expected, "interleavePlanes", count, offset);
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Benchmark
+//////////////////////////////////////////////////////////////////////////
+
+/**
+ * Runs the transform for at least sBenchmarkTime seconds
+ * @return the throughput in MB/s of source data
+ */
+static double measure(const std::function<void()>& transform, size_t sourceBytes)
+{
+    using Clock = std::chrono::steady_clock;
+    transform();
+
+    int runs = 0;
+    Clock::time_point start = Clock::now();
+    double elapsed = 0.0;
+    while (elapsed < sBenchmarkTime)
+    {
+        transform();
+        runs++;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    return static_cast<double>(sourceBytes) * runs / elapsed / 1.0e6;
+}
+
+
+static void benchmark(const char* transform, const std::function<void()>& reference, const std::function<void()>& dispatched, size_t sourceBytes)
+{
+    double reference_rate = measure(reference, sourceBytes);
+    double dispatched_rate = measure(dispatched, sourceBytes);
+    std::printf("%-24s scalar %8.0f MB/s, dispatched %8.0f MB/s, %5.1fx\n", transform, reference_rate, dispatched_rate, dispatched_rate / reference_rate);
+}
+
+
+static void runBenchmarks(std::mt19937& random)
+{
+    const int width = sBenchmarkWidth;
+    const int height = sBenchmarkHeight;
+    std::printf("Benchmark, %dx%d planes:\n", width, height);
+
+    Source rgb(random, 0, width * 3, height);
+    Plane rgba(0, width * 4, height);
+    benchmark("expandRGB24Plane",
+        [&]() { expandRGB24Reference(rgb.getData(), rgb.mStride, rgba.getData(), rgba.mStride, width, height); },
+        [&]() { utility::expandRGB24Plane(rgb.getData(), rgb.mStride, rgba.getData(), rgba.mStride, width, height); },
+        static_cast<size_t>(width) * 3 * height);
+
+    Source wide(random, 0, width * 2, height);
+    Plane swapped(0, width * 2, height);
+    benchmark("swapBytes16Plane",
+        [&]() { swapBytes16Reference(wide.getData(), wide.mStride, swapped.getData(), swapped.mStride, width, height); },
+        [&]() { utility::swapBytes16Plane(wide.getData(), wide.mStride, swapped.getData(), swapped.mStride, width, height); },
+        static_cast<size_t>(width) * 2 * height);
+
+    Plane narrow(0, width, height);
+    for (bool big_endian : { false, true })
+    {
+        benchmark(big_endian ? "ditherTo8BitPlane 10 BE" : "ditherTo8BitPlane 10 LE",
+            [&]() { ditherTo8BitReference(wide.getData(), wide.mStride, narrow.getData(), narrow.mStride, width, height, 10, big_endian); },
+            [&]() { utility::ditherTo8BitPlane(wide.getData(), wide.mStride, narrow.getData(), narrow.mStride, width, height, 10, big_endian); },
+            static_cast<size_t>(width) * 2 * height);
+    }
+
+    // Chroma planes of a 4:2:0 frame
+    Source u(random, 0, width / 2, height / 2);
+    Source v(random, 0, width / 2, height / 2);
+    Plane uv(0, width, height / 2);
+    benchmark("interleavePlanes",
+        [&]() { interleaveReference(u.getData(), u.mStride, v.getData(), v.mStride, uv.getData(), uv.mStride, width / 2, height / 2); },
+        [&]() { utility::interleavePlanes(u.getData(), u.mStride, v.getData(), v.mStride, uv.getData(), uv.mStride, width / 2, height / 2); },
+        static_cast<size_t>(width) * (height / 2));
+}
+
+
+int main(int argc, char* argv[])
+{
+    std::mt19937 random(5489u);
+    for (int offset : sOffsets)
+    {
+        for (int count : sCounts)
+        {
+            checkExpandRGB24(random, count, offset);
+            checkSwapBytes16(random, count, offset);
+            checkInterleave(random, count, offset);
+            for (int bits : { 9, 10, 12, 16 })
+            {
+                checkDitherTo8Bit(random, count, offset, bits, false);
+                checkDitherTo8Bit(random, count, offset, bits, true);
+            }
+        }
+    }
+    std::printf("%d of %d plane transform checks failed\n", sFailures, sChecks);
+
+    bool skip_benchmark = argc > 1 && std::strcmp(argv[1], "--no-benchmark") == 0;
+    if (sFailures == 0 && !skip_benchmark)
+        runBenchmarks(random);
+
+    return sFailures == 0 ? 0 : 1;
+}